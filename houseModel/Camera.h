@@ -72,6 +72,36 @@ public:
         return glm::lookAt(this->Position, this->Position + this->Front, this->Up);
     }
 
+    // World space ray through the screen point (ndcX, ndcY), both in [-1, 1], starting on the near plane;
+    // direction has unit length
+    void GetPickRay(const glm::mat4& projection, float ndcX, float ndcY, glm::vec3& origin, glm::vec3& direction)
+    {
+        glm::mat4 inverseClip = glm::inverse(projection * this->GetViewMatrix());
+        glm::vec4 nearPoint = inverseClip * glm::vec4(ndcX, ndcY, -1.0f, 1.0f);
+        glm::vec4 farPoint = inverseClip * glm::vec4(ndcX, ndcY, 1.0f, 1.0f);
+        origin = glm::vec3(nearPoint) / nearPoint.w;
+        direction = glm::normalize(glm::vec3(farPoint) / farPoint.w - origin);
+    }
+
+    // World space planes (xyz normal pointing inside, w distance) of the view frustum under projection:
+    // left, right, bottom, top, near, far, normalized so plane distances are in world units
+    void GetFrustumPlanes(const glm::mat4& projection, glm::vec4 planes[6])
+    {
+        // Gribb/Hartmann: sums and differences of the rows of projection * view
+        glm::mat4 clip = projection * this->GetViewMatrix();
+        for (int i = 0; i < 3; i++)
+        {
+            for (int side = 0; side < 2; side++)
+            {
+                glm::vec4 plane;
+                for (int column = 0; column < 4; column++)
+                    plane[column] = clip[column][3] + (side == 0 ? clip[column][i] : -clip[column][i]);
+                float length = glm::length(glm::vec3(plane.x, plane.y, plane.z));
+                planes[i * 2 + side] = length > 0.0f ? plane / length : plane;
+            }
+        }
+    }
+
     // Processes input received from any keyboard-like input system. Accepts input parameter in the form of camera defined ENUM (to abstract it from windowing systems)
     void ProcessKeyboard(Camera_Movement direction, GLfloat deltaTime)
     {
@@ -0,0 +1,239 @@
+#include "CascadedShadowMap.h"
+// Std. Includes
+#include <string>
+#include <cmath>
+#include <cfloat>
+#include <iostream>
+#include <algorithm>
+
+// GL Includes
+#include <glm/gtc/matrix_transform.hpp>
+
+// Element names of the cascade uniform arrays, one per MAX_SHADOW_CASCADES
+static const std::string lightSpaceNames[] = { "cascadeLightSpace[0]", "cascadeLightSpace[1]", "cascadeLightSpace[2]", "cascadeLightSpace[3]" };
+static const std::string splitNames[] = { "cascadeSplits[0]", "cascadeSplits[1]", "cascadeSplits[2]", "cascadeSplits[3]" };
+static const std::string normalOffsetNames[] = { "cascadeNormalOffsets[0]", "cascadeNormalOffsets[1]", "cascadeNormalOffsets[2]", "cascadeNormalOffsets[3]" };
+
+CascadedShadowMap::CascadedShadowMap(unsigned int resolution, unsigned int cascadeCount, float shadowDistance)
+	: splitLambda(0.75f), blendFraction(0.1f), casterDistance(20.0f), cacheSnap(0.125f), castersDrawn(0), castersCulled(0), cacheHits(0), cacheMisses(0),
+	resolution(resolution), count(std::min(std::max(cascadeCount, 1u), MAX_SHADOW_CASCADES)), shadowDistance(shadowDistance)
+{
+	glGenTextures(1, &staticDepthArray);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, staticDepthArray);
+	glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT24, resolution, resolution, count, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glGenTextures(1, &depthArray);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, depthArray);
+	glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT24, resolution, resolution, count, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+	// Hardware depth compare with bilinear filtering, sampled through sampler2DArrayShadow
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+	glGenFramebuffers(1, &framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, depthArray, 0, 0);
+	glDrawBuffer(GL_NONE);
+	glReadBuffer(GL_NONE);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		std::cout << "ERROR::SHADOW::FRAMEBUFFER_INCOMPLETE" << std::endl;
+	glGenFramebuffers(1, &staticFramebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, staticFramebuffer);
+	glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, staticDepthArray, 0, 0);
+	glDrawBuffer(GL_NONE);
+	glReadBuffer(GL_NONE);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	for (unsigned int cascade = 0; cascade < MAX_SHADOW_CASCADES; cascade++)
+	{
+		lightSpaceMatrices[cascade] = glm::mat4(1.0f);
+		splitDepths[cascade] = 0.0f;
+		texelSizes[cascade] = 0.0f;
+	}
+	invalidateCache();
+}
+
+CascadedShadowMap::~CascadedShadowMap()
+{
+	glDeleteFramebuffers(1, &framebuffer);
+	glDeleteFramebuffers(1, &staticFramebuffer);
+	glDeleteTextures(1, &depthArray);
+	glDeleteTextures(1, &staticDepthArray);
+}
+
+void CascadedShadowMap::update(const glm::vec3& lightDirection, const glm::mat4& view, const glm::mat4& projection, float nearPlane)
+{
+	castersDrawn = 0;
+	castersCulled = 0;
+	cacheHits = 0;
+	cacheMisses = 0;
+
+	// View space rays through the frustum corners, scaled to unit depth
+	glm::mat4 inverseProjection = glm::inverse(projection);
+	glm::vec3 rays[4];
+	for (unsigned int corner = 0; corner < 4; corner++)
+	{
+		glm::vec4 point = inverseProjection * glm::vec4((corner & 1) ? 1.0f : -1.0f, (corner & 2) ? 1.0f : -1.0f, -1.0f, 1.0f);
+		rays[corner] = glm::vec3(point) / point.w;
+		rays[corner] /= -rays[corner].z;
+	}
+	glm::mat4 inverseView = glm::inverse(view);
+
+	// Light looks along lightDirection from the origin, the cascades only differ in their ortho box
+	glm::vec3 direction = glm::normalize(lightDirection);
+	glm::vec3 up = std::abs(direction.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+	glm::mat4 lightView = glm::lookAt(glm::vec3(0.0f), direction, up);
+
+	float sliceNear = nearPlane;
+	for (unsigned int cascade = 0; cascade < count; cascade++)
+	{
+		float fraction = (float)(cascade + 1) / count;
+		float logarithmic = nearPlane * std::pow(shadowDistance / nearPlane, fraction);
+		float uniform = nearPlane + (shadowDistance - nearPlane) * fraction;
+		float sliceFar = splitLambda * logarithmic + (1.0f - splitLambda) * uniform;
+		splitDepths[cascade] = sliceFar;
+
+		// Bounding sphere of the slice, its size does not change with the camera's orientation
+		glm::vec3 corners[8];
+		glm::vec3 center(0.0f);
+		for (unsigned int corner = 0; corner < 8; corner++)
+		{
+			glm::vec3 viewPoint = rays[corner & 3] * ((corner & 4) ? sliceFar : sliceNear);
+			corners[corner] = glm::vec3(inverseView * glm::vec4(viewPoint, 1.0f));
+			center += corners[corner] / 8.0f;
+		}
+		float radius = 0.0f;
+		for (unsigned int corner = 0; corner < 8; corner++)
+			radius = std::max(radius, glm::length(corners[corner] - center));
+		radius = std::ceil(radius * 16.0f) / 16.0f;
+
+		// Move the box by whole texels only, and by at least cacheSnap of the radius, which it is padded by
+		float halfSize = radius * (1.0f + cacheSnap);
+		float texelSize = 2.0f * halfSize / resolution;
+		float step = std::max(texelSize, std::floor(radius * cacheSnap / texelSize) * texelSize);
+		glm::vec3 lightCenter = glm::vec3(lightView * glm::vec4(center, 1.0f));
+		lightCenter.x = std::floor(lightCenter.x / step) * step;
+		lightCenter.y = std::floor(lightCenter.y / step) * step;
+		lightCenter.z = std::floor(lightCenter.z / step) * step;
+		glm::mat4 lightProjection = glm::ortho(lightCenter.x - halfSize, lightCenter.x + halfSize, lightCenter.y - halfSize, lightCenter.y + halfSize,
+			-lightCenter.z - halfSize - casterDistance, -lightCenter.z + halfSize);
+		lightSpaceMatrices[cascade] = lightProjection * lightView;
+		texelSizes[cascade] = texelSize;
+
+		// Planes of the light volume for caster culling
+		const glm::mat4& m = lightSpaceMatrices[cascade];
+		glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+		glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+		glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+		glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+		planes[cascade][0] = row3 + row0;
+		planes[cascade][1] = row3 - row0;
+		planes[cascade][2] = row3 + row1;
+		planes[cascade][3] = row3 - row1;
+		planes[cascade][4] = row3 + row2;
+		planes[cascade][5] = row3 - row2;
+
+		sliceNear = sliceFar;
+	}
+}
+
+bool CascadedShadowMap::beginStaticCasters(unsigned int cascade, size_t signature)
+{
+	staticRedrawn[cascade] = false;
+	if (cacheValid[cascade] && cachedLightSpace[cascade] == lightSpaceMatrices[cascade] && cachedSignature[cascade] == signature)
+	{
+		cacheHits++;
+		return false;
+	}
+	cacheMisses++;
+	cacheValid[cascade] = true;
+	cachedLightSpace[cascade] = lightSpaceMatrices[cascade];
+	cachedSignature[cascade] = signature;
+	staticRedrawn[cascade] = true;
+
+	glBindFramebuffer(GL_FRAMEBUFFER, staticFramebuffer);
+	glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, staticDepthArray, 0, cascade);
+	glViewport(0, 0, resolution, resolution);
+	glClear(GL_DEPTH_BUFFER_BIT);
+	// Slope scaled bias against acne, the receiver side adds a normal offset
+	glEnable(GL_POLYGON_OFFSET_FILL);
+	glPolygonOffset(2.0f, 4.0f);
+	return true;
+}
+
+bool CascadedShadowMap::beginDynamicCasters(unsigned int cascade, bool anyDynamic)
+{
+	// The sampled layer is still right: same static depth, and no dynamic casters now or last frame
+	if (!staticRedrawn[cascade] && !anyDynamic && !dynamicComposited[cascade])
+		return false;
+	dynamicComposited[cascade] = anyDynamic;
+
+	// Start from the static depth
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, staticFramebuffer);
+	glFramebufferTextureLayer(GL_READ_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, staticDepthArray, 0, cascade);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer);
+	glFramebufferTextureLayer(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, depthArray, 0, cascade);
+	glBlitFramebuffer(0, 0, resolution, resolution, 0, 0, resolution, resolution, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+	if (!anyDynamic)
+		return false;
+
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glViewport(0, 0, resolution, resolution);
+	glEnable(GL_POLYGON_OFFSET_FILL);
+	glPolygonOffset(2.0f, 4.0f);
+	return true;
+}
+
+void CascadedShadowMap::invalidateCache()
+{
+	for (unsigned int cascade = 0; cascade < MAX_SHADOW_CASCADES; cascade++)
+	{
+		cacheValid[cascade] = false;
+		staticRedrawn[cascade] = false;
+		dynamicComposited[cascade] = false;
+	}
+}
+
+void CascadedShadowMap::endCascades()
+{
+	glDisable(GL_POLYGON_OFFSET_FILL);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+bool CascadedShadowMap::casterVisible(unsigned int cascade, const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+{
+	for (unsigned int plane = 0; plane < 6; plane++)
+	{
+		const glm::vec4& p = planes[cascade][plane];
+		// Corner furthest along the plane normal
+		glm::vec3 positive(p.x >= 0.0f ? boundsMax.x : boundsMin.x, p.y >= 0.0f ? boundsMax.y : boundsMin.y, p.z >= 0.0f ? boundsMax.z : boundsMin.z);
+		if (glm::dot(glm::vec3(p), positive) + p.w < 0.0f)
+		{
+			castersCulled++;
+			return false;
+		}
+	}
+	castersDrawn++;
+	return true;
+}
+
+void CascadedShadowMap::bind(const Shader& shader) const
+{
+	glActiveTexture(GL_TEXTURE0 + SHADOW_CASCADES_UNIT);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, depthArray);
+	glActiveTexture(GL_TEXTURE0);
+	shader.setInt("shadowCascades", SHADOW_CASCADES_UNIT);
+	shader.setInt("shadowCascadeCount", count);
+	shader.setFloat("cascadeBlend", blendFraction);
+	for (unsigned int cascade = 0; cascade < count; cascade++)
+	{
+		shader.setMat4(lightSpaceNames[cascade], lightSpaceMatrices[cascade]);
+		shader.setFloat(splitNames[cascade], splitDepths[cascade]);
+		shader.setFloat(normalOffsetNames[cascade], 1.5f * texelSizes[cascade]);
+	}
+}
@@ -0,0 +1,90 @@
+#pragma once
+// Std. Includes
+#include <cstddef>
+
+// GL Includes
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "Shader.h"
+
+const unsigned int MAX_SHADOW_CASCADES = 4;
+// Texture unit of the cascades, above the cluster buffers of LightClusters.h
+const unsigned int SHADOW_CASCADES_UNIT = 10;
+
+// Cascaded shadow map of the directional light. The camera frustum up to shadowDistance is split
+// into cascades (blend of logarithmic and uniform splits), each fitted with an orthographic light
+// projection around the bounding sphere of its slice. Sphere fitting plus snapping the center to
+// whole texels keeps the shadow edges from crawling as the camera moves or turns. All cascades are
+// layers of one depth texture array; lighting.glsl picks the cascade per fragment and fades into
+// the next one over the last blendFraction of each.
+// Static casters are cached: their depth is kept in a second array and only re-rendered when the
+// cascade's light projection or the static casters changed, dynamic casters are drawn every frame
+// over a copy of it. Boxes move in steps of cacheSnap of their radius, so a walking camera keeps
+// hitting the cache for a while before the cascade is refitted.
+class CascadedShadowMap {
+    public:
+        CascadedShadowMap(unsigned int resolution = 2048, unsigned int cascadeCount = MAX_SHADOW_CASCADES, float shadowDistance = 20.0f);
+        ~CascadedShadowMap();
+
+        // Refits the cascades, projection is the camera's (near/far are taken from nearPlane and shadowDistance)
+        void update(const glm::vec3& lightDirection, const glm::mat4& view, const glm::mat4& projection, float nearPlane);
+        // Starts the static casters of a cascade, signature identifies them (see staticCasterSignature).
+        // False on a cache hit: the cached depth is still right and nothing has to be drawn
+        bool beginStaticCasters(unsigned int cascade, size_t signature);
+        // Starts the dynamic casters of a cascade over the static depth, false when there is nothing to draw
+        bool beginDynamicCasters(unsigned int cascade, bool anyDynamic);
+        // Back to the default framebuffer, the caller restores its viewport
+        void endCascades();
+        // Forces the static casters of every cascade to be drawn again
+        void invalidateCache();
+        // Whether a caster with this world AABB can throw a shadow into the cascade
+        bool casterVisible(unsigned int cascade, const glm::vec3& boundsMin, const glm::vec3& boundsMax);
+        // Binds the cascades and sets the shadow uniforms of lighting.glsl, the shader has to be in use
+        void bind(const Shader& shader) const;
+
+        const glm::mat4& lightSpaceMatrix(unsigned int cascade) const { return lightSpaceMatrices[cascade]; }
+        unsigned int cascadeCount() const { return count; }
+
+        // 0 splits the distance uniformly, 1 logarithmically
+        float splitLambda;
+        // Part of a cascade over which it is blended into the next
+        float blendFraction;
+        // How far behind a cascade (towards the light) casters are still caught
+        float casterDistance;
+        // Part of a cascade's radius the camera may move before the cascade is refitted, the box is
+        // padded by as much, trading resolution for shadow cache hits
+        float cacheSnap;
+
+        // Statistics, casterVisible() results since the last update()
+        unsigned int castersDrawn;
+        unsigned int castersCulled;
+        // Cascades whose static depth was reused / drawn again
+        unsigned int cacheHits;
+        unsigned int cacheMisses;
+
+    private:
+        CascadedShadowMap(const CascadedShadowMap&);
+        CascadedShadowMap& operator=(const CascadedShadowMap&);
+
+        unsigned int resolution;
+        unsigned int count;
+        float shadowDistance;
+        GLuint framebuffer, depthArray;
+        // Depth of the static casters only, copied into depthArray before dynamic casters are drawn
+        GLuint staticFramebuffer, staticDepthArray;
+        // What the static depth of each cascade was drawn with
+        bool cacheValid[MAX_SHADOW_CASCADES];
+        glm::mat4 cachedLightSpace[MAX_SHADOW_CASCADES];
+        size_t cachedSignature[MAX_SHADOW_CASCADES];
+        // Static depth drawn this frame / depthArray holds dynamic casters of the last frame
+        bool staticRedrawn[MAX_SHADOW_CASCADES];
+        bool dynamicComposited[MAX_SHADOW_CASCADES];
+        glm::mat4 lightSpaceMatrices[MAX_SHADOW_CASCADES];
+        // View depth each cascade ends at
+        float splitDepths[MAX_SHADOW_CASCADES];
+        // World size of a shadow texel, the receiver is pushed along its normal by about that much
+        float texelSizes[MAX_SHADOW_CASCADES];
+        // World space planes of every cascade's light volume, normals pointing inside
+        glm::vec4 planes[MAX_SHADOW_CASCADES][6];
+};
@@ -0,0 +1,131 @@
+#include "FrustumCuller.h"
+// Std. Includes
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define FRUSTUM_CULLER_SSE
+#include <xmmintrin.h>
+#endif
+
+FrustumCuller::FrustumCuller()
+	: meshesDrawn(0), meshesCulled(0), objectsCulled(0)
+{
+}
+
+// The AABB of a local box under transform (Arvo), outside when it is fully behind one plane
+static bool boxVisible(const glm::mat4& transform, const glm::vec3& localMin, const glm::vec3& localMax, const glm::vec4 planes[6])
+{
+	glm::vec3 center = glm::vec3(transform * glm::vec4((localMin + localMax) * 0.5f, 1.0f));
+	glm::vec3 localExtent = (localMax - localMin) * 0.5f;
+	glm::vec3 extent(0.0f);
+	for (int column = 0; column < 3; column++)
+		for (int row = 0; row < 3; row++)
+			extent[row] += std::fabs(transform[column][row]) * localExtent[column];
+	for (int plane = 0; plane < 6; plane++)
+	{
+		glm::vec3 normal(planes[plane]);
+		float reach = std::fabs(normal.x) * extent.x + std::fabs(normal.y) * extent.y + std::fabs(normal.z) * extent.z;
+		if (glm::dot(normal, center) + planes[plane].w < -reach)
+			return false;
+	}
+	return true;
+}
+
+void FrustumCuller::cull(const std::vector<SceneObject>& objects, const glm::vec4 planes[6])
+{
+	// Gather the world spheres, the radius grows with the largest axis scale
+	firstMesh.resize(objects.size() + 1);
+	unsigned int meshCount = 0;
+	for (unsigned int i = 0; i < objects.size(); i++)
+	{
+		firstMesh[i] = meshCount;
+		meshCount += (unsigned int)objects[i].model->meshes.size();
+	}
+	firstMesh[objects.size()] = meshCount;
+	unsigned int paddedCount = (meshCount + 3) & ~3u;
+	centerX.assign(paddedCount, 0.0f);
+	centerY.assign(paddedCount, 0.0f);
+	centerZ.assign(paddedCount, 0.0f);
+	radius.assign(paddedCount, 0.0f);
+	visible.assign(paddedCount, 1);
+	crossing.assign(paddedCount, 0);
+	for (unsigned int i = 0; i < objects.size(); i++)
+	{
+		const glm::mat4& transform = objects[i].transform;
+		float scale = std::sqrt(std::max(glm::dot(glm::vec3(transform[0]), glm::vec3(transform[0])),
+			std::max(glm::dot(glm::vec3(transform[1]), glm::vec3(transform[1])), glm::dot(glm::vec3(transform[2]), glm::vec3(transform[2])))));
+		const std::vector<Mesh>& meshes = objects[i].model->meshes;
+		for (unsigned int mesh = 0; mesh < meshes.size(); mesh++)
+		{
+			unsigned int index = firstMesh[i] + mesh;
+			glm::vec3 center = glm::vec3(transform * glm::vec4(meshes[mesh].boundsCenter, 1.0f));
+			centerX[index] = center.x;
+			centerY[index] = center.y;
+			centerZ[index] = center.z;
+			radius[index] = meshes[mesh].boundsRadius * scale;
+		}
+	}
+
+	// Sphere against the six planes: out when behind any, crossing when within radius of one
+	unsigned int index = 0;
+#ifdef FRUSTUM_CULLER_SSE
+	for (; index < paddedCount; index += 4)
+	{
+		__m128 x = _mm_loadu_ps(&centerX[index]);
+		__m128 y = _mm_loadu_ps(&centerY[index]);
+		__m128 z = _mm_loadu_ps(&centerZ[index]);
+		__m128 r = _mm_loadu_ps(&radius[index]);
+		__m128 negativeR = _mm_sub_ps(_mm_setzero_ps(), r);
+		__m128 outside = _mm_setzero_ps();
+		__m128 inside = _mm_cmpge_ps(r, r);
+		for (int plane = 0; plane < 6; plane++)
+		{
+			__m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(planes[plane].x)), _mm_mul_ps(y, _mm_set1_ps(planes[plane].y))),
+				_mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(planes[plane].z)), _mm_set1_ps(planes[plane].w)));
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, negativeR));
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, r));
+		}
+		int outsideMask = _mm_movemask_ps(outside);
+		int insideMask = _mm_movemask_ps(inside);
+		for (int lane = 0; lane < 4; lane++)
+		{
+			visible[index + lane] = (outsideMask >> lane) & 1 ? 0 : 1;
+			crossing[index + lane] = visible[index + lane] && !((insideMask >> lane) & 1);
+		}
+	}
+#endif
+	for (; index < meshCount; index++)
+	{
+		bool outside = false, inside = true;
+		for (int plane = 0; plane < 6; plane++)
+		{
+			float distance = centerX[index] * planes[plane].x + centerY[index] * planes[plane].y + centerZ[index] * planes[plane].z + planes[plane].w;
+			outside = outside || distance < -radius[index];
+			inside = inside && distance >= radius[index];
+		}
+		visible[index] = outside ? 0 : 1;
+		crossing[index] = !outside && !inside;
+	}
+
+	// Crossing spheres get the box test, then count per object
+	meshesDrawn = 0;
+	meshesCulled = 0;
+	objectsCulled = 0;
+	visibleCounts.assign(objects.size(), 0);
+	for (unsigned int i = 0; i < objects.size(); i++)
+	{
+		const std::vector<Mesh>& meshes = objects[i].model->meshes;
+		for (unsigned int mesh = 0; mesh < meshes.size(); mesh++)
+		{
+			unsigned int flag = firstMesh[i] + mesh;
+			if (crossing[flag] && !boxVisible(objects[i].transform, meshes[mesh].boundsMin, meshes[mesh].boundsMax, planes))
+				visible[flag] = 0;
+			visibleCounts[i] += visible[flag];
+		}
+		meshesDrawn += visibleCounts[i];
+		meshesCulled += (unsigned int)meshes.size() - visibleCounts[i];
+		if (visibleCounts[i] == 0)
+			objectsCulled++;
+	}
+}
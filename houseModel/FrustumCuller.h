@@ -0,0 +1,42 @@
+#pragma once
+// Std. Includes
+#include <vector>
+
+// GL Includes
+#include <glm/glm.hpp>
+
+#include "SceneObject.h"
+
+// View frustum culling of every mesh of the scene objects. cull() moves the bounding sphere of each
+// mesh to world space into structure of arrays and tests them four at a time against the planes with
+// SSE; meshes whose sphere crosses a plane get a second, tighter test with their world AABB.
+// Visibility is read per object as one flag per mesh of its model, which Model::Draw takes.
+class FrustumCuller {
+    public:
+        FrustumCuller();
+
+        // planes: world space, pointing inside (Camera::GetFrustumPlanes)
+        void cull(const std::vector<SceneObject>& objects, const glm::vec4 planes[6]);
+        // Flags of the meshes of object i in the last cull()
+        const unsigned char* visibleMeshes(unsigned int object) const { return &visible[firstMesh[object]]; }
+        // False when no mesh of object i is in the frustum, the object needs no draw at all
+        bool objectVisible(unsigned int object) const { return visibleCounts[object] > 0; }
+
+        // Statistics of the last cull()
+        unsigned int meshesDrawn;
+        unsigned int meshesCulled;
+        unsigned int objectsCulled;
+
+    private:
+        FrustumCuller(const FrustumCuller&);
+        FrustumCuller& operator=(const FrustumCuller&);
+
+        // World space spheres of all meshes, padded to a multiple of four
+        std::vector<float> centerX, centerY, centerZ, radius;
+        // Index of every object's first mesh in the arrays, plus one past the last object
+        std::vector<unsigned int> firstMesh;
+        std::vector<unsigned int> visibleCounts;
+        std::vector<unsigned char> visible;
+        // The sphere crosses a plane, the AABB decides
+        std::vector<unsigned char> crossing;
+};
@@ -0,0 +1,90 @@
+#include "GBuffer.h"
+// Std. Includes
+#include <iostream>
+
+static GLuint createTarget(GLint internalFormat, GLenum format, GLenum type, unsigned int width, unsigned int height)
+{
+	GLuint texture;
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, type, NULL);
+	// Read back with texelFetch, one texel per pixel
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	return texture;
+}
+
+GBuffer::GBuffer(unsigned int width, unsigned int height)
+	: width(width), height(height), blendEnabled(GL_FALSE)
+{
+	albedoSpecular = createTarget(GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, width, height);
+	normalShininess = createTarget(GL_RGB10_A2, GL_RGBA, GL_UNSIGNED_INT_2_10_10_10_REV, width, height);
+	depth = createTarget(GL_DEPTH24_STENCIL8, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, width, height);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	glGenFramebuffers(1, &framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, albedoSpecular, 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, normalShininess, 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, depth, 0);
+	GLenum drawBuffers[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+	glDrawBuffers(2, drawBuffers);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		std::cout << "ERROR::GBUFFER::FRAMEBUFFER_INCOMPLETE" << std::endl;
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	glGenVertexArrays(1, &emptyVAO);
+}
+
+GBuffer::~GBuffer()
+{
+	glDeleteVertexArrays(1, &emptyVAO);
+	glDeleteFramebuffers(1, &framebuffer);
+	glDeleteTextures(1, &albedoSpecular);
+	glDeleteTextures(1, &normalShininess);
+	glDeleteTextures(1, &depth);
+}
+
+void GBuffer::bindForGeometry()
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glViewport(0, 0, width, height);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	// The alpha channels hold specular and padding, not coverage
+	blendEnabled = glIsEnabled(GL_BLEND);
+	glDisable(GL_BLEND);
+}
+
+void GBuffer::bindForLighting(const Shader& shader, const glm::mat4& viewProjection) const
+{
+	glActiveTexture(GL_TEXTURE0 + GBUFFER_ALBEDO_SPECULAR_UNIT);
+	glBindTexture(GL_TEXTURE_2D, albedoSpecular);
+	glActiveTexture(GL_TEXTURE0 + GBUFFER_NORMAL_SHININESS_UNIT);
+	glBindTexture(GL_TEXTURE_2D, normalShininess);
+	glActiveTexture(GL_TEXTURE0 + GBUFFER_DEPTH_UNIT);
+	glBindTexture(GL_TEXTURE_2D, depth);
+	glActiveTexture(GL_TEXTURE0);
+	shader.setInt("gAlbedoSpecular", GBUFFER_ALBEDO_SPECULAR_UNIT);
+	shader.setInt("gNormalShininess", GBUFFER_NORMAL_SHININESS_UNIT);
+	shader.setInt("gDepth", GBUFFER_DEPTH_UNIT);
+	shader.setMat4("inverseViewProjection", glm::inverse(viewProjection));
+}
+
+void GBuffer::drawLighting()
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glDisable(GL_DEPTH_TEST);
+	glBindVertexArray(emptyVAO);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+	glBindVertexArray(0);
+	glEnable(GL_DEPTH_TEST);
+	if (blendEnabled)
+		glEnable(GL_BLEND);
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+	glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
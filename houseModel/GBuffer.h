@@ -0,0 +1,43 @@
+#pragma once
+// GL Includes
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "Shader.h"
+
+// Texture units of the targets in the lighting pass
+const unsigned int GBUFFER_ALBEDO_SPECULAR_UNIT = 0;
+const unsigned int GBUFFER_NORMAL_SHININESS_UNIT = 1;
+const unsigned int GBUFFER_DEPTH_UNIT = 2;
+
+// Render targets of the deferred path, 8 bytes of color per pixel plus depth:
+//   0      RGBA8             albedo, specular intensity
+//   1      RGB10_A2          octahedral normal, shininess (0..1023)
+//   depth  DEPTH24_STENCIL8  world positions are reconstructed from it
+// gBufferFragmentShader.frag fills it with the materials of the scene, deferredLightingShader.frag then
+// shades every covered pixel once, so lighting cost no longer depends on overdraw.
+class GBuffer {
+    public:
+        GBuffer(unsigned int width, unsigned int height);
+        ~GBuffer();
+
+        // Binds and clears the targets for the geometry pass, blending is off until drawLighting
+        void bindForGeometry();
+        // Binds the targets as textures and sets the lighting pass uniforms, the shader has to be in use
+        void bindForLighting(const Shader& shader, const glm::mat4& viewProjection) const;
+        // Shades the covered pixels into the default framebuffer with a full screen triangle, then copies
+        // the depth there so objects drawn forward afterwards (windows) are still occluded
+        void drawLighting();
+
+        unsigned int width, height;
+
+    private:
+        GBuffer(const GBuffer&);
+        GBuffer& operator=(const GBuffer&);
+
+        GLuint framebuffer;
+        GLuint albedoSpecular, normalShininess, depth;
+        // Core profile needs a vertex array bound even without attributes
+        GLuint emptyVAO;
+        GLboolean blendEnabled;
+};
@@ -0,0 +1,156 @@
+#include "LightBuffer.h"
+// Std. Includes
+#include <vector>
+#include <cstring>
+#include <algorithm>
+#include <iostream>
+
+LightBuffer::LightBuffer()
+	: uploads(0), lightsDirty(true), firstDirtyPoint(0), endDirtyPoint(0)
+{
+	lights = LightsBlock();
+	glGenBuffers(1, &lightsUBO);
+	glBindBuffer(GL_UNIFORM_BUFFER, lightsUBO);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(LightsBlock), &lights, GL_DYNAMIC_DRAW);
+	glGenBuffers(1, &pointLightsUBO);
+	glBindBuffer(GL_UNIFORM_BUFFER, pointLightsUBO);
+	glBufferData(GL_UNIFORM_BUFFER, MAX_POINT_LIGHTS * sizeof(GPUPointLight), NULL, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	glBindBufferBase(GL_UNIFORM_BUFFER, LIGHTS_BINDING, lightsUBO);
+	glBindBufferBase(GL_UNIFORM_BUFFER, POINT_LIGHTS_BINDING, pointLightsUBO);
+}
+
+LightBuffer::~LightBuffer()
+{
+	glDeleteBuffers(1, &lightsUBO);
+	glDeleteBuffers(1, &pointLightsUBO);
+}
+
+void LightBuffer::setDirectional(const LightDirectional& light)
+{
+	GPUDirLight packed = GPUDirLight();
+	packed.direction = light.direction;
+	packed.ambient = light.ambient;
+	packed.diffuse = light.diffuse;
+	packed.specular = light.specular;
+	if (memcmp(&packed, &lights.dirLight, sizeof(packed)) != 0)
+	{
+		lights.dirLight = packed;
+		lightsDirty = true;
+	}
+}
+
+void LightBuffer::setSpot(const LightSpot& light)
+{
+	GPUSpotLight packed;
+	packed.position = light.position;
+	packed.innerCutOff = light.innerCutOff;
+	packed.direction = light.direction;
+	packed.outerCutOff = light.outerCutOff;
+	packed.ambient = light.ambient;
+	packed.constant = light.constant;
+	packed.diffuse = light.diffuse;
+	packed.linear = light.linear;
+	packed.specular = light.specular;
+	packed.quadratic = light.quadratic;
+	if (!lights.spotLightEnabled || memcmp(&packed, &lights.spotLight, sizeof(packed)) != 0)
+	{
+		lights.spotLight = packed;
+		lights.spotLightEnabled = 1;
+		lightsDirty = true;
+	}
+}
+
+void LightBuffer::disableSpot()
+{
+	if (lights.spotLightEnabled)
+	{
+		lights.spotLightEnabled = 0;
+		lightsDirty = true;
+	}
+}
+
+GPUPointLight LightBuffer::pack(const LightPoint& light)
+{
+	GPUPointLight packed;
+	packed.position = light.position;
+	packed.constant = light.constant;
+	packed.ambient = light.ambient;
+	packed.linear = light.linear;
+	packed.diffuse = light.diffuse;
+	packed.quadratic = light.quadratic;
+	packed.specular = light.specular;
+	packed.shadowIndex = (float)light.shadowIndex;
+	return packed;
+}
+
+unsigned int LightBuffer::addPoint(const LightPoint& light)
+{
+	if (pointLights.size() >= MAX_POINT_LIGHTS)
+	{
+		std::cout << "LightBuffer: more than " << MAX_POINT_LIGHTS << " point lights, dropping one" << std::endl;
+		return MAX_POINT_LIGHTS;
+	}
+	unsigned int index = (unsigned int)pointLights.size();
+	pointLights.push_back(pack(light));
+	markPointDirty(index);
+	lights.pointLightCount = (int)pointLights.size();
+	lightsDirty = true;
+	return index;
+}
+
+void LightBuffer::setPoint(unsigned int index, const LightPoint& light)
+{
+	if (index >= pointLights.size())
+		return;
+	GPUPointLight packed = pack(light);
+	if (memcmp(&packed, &pointLights[index], sizeof(packed)) == 0)
+		return;
+	pointLights[index] = packed;
+	markPointDirty(index);
+}
+
+void LightBuffer::markPointDirty(unsigned int index)
+{
+	if (firstDirtyPoint >= endDirtyPoint)
+	{
+		firstDirtyPoint = index;
+		endDirtyPoint = index + 1;
+	}
+	else
+	{
+		firstDirtyPoint = std::min(firstDirtyPoint, index);
+		endDirtyPoint = std::max(endDirtyPoint, index + 1);
+	}
+}
+
+void LightBuffer::clearPoints()
+{
+	pointLights.clear();
+	firstDirtyPoint = endDirtyPoint = 0;
+	if (lights.pointLightCount != 0)
+	{
+		lights.pointLightCount = 0;
+		lightsDirty = true;
+	}
+}
+
+void LightBuffer::update()
+{
+	if (lightsDirty)
+	{
+		glBindBuffer(GL_UNIFORM_BUFFER, lightsUBO);
+		glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(LightsBlock), &lights);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+		lightsDirty = false;
+		uploads++;
+	}
+	if (firstDirtyPoint < endDirtyPoint)
+	{
+		glBindBuffer(GL_UNIFORM_BUFFER, pointLightsUBO);
+		glBufferSubData(GL_UNIFORM_BUFFER, firstDirtyPoint * sizeof(GPUPointLight), (endDirtyPoint - firstDirtyPoint) * sizeof(GPUPointLight), &pointLights[firstDirtyPoint]);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+		firstDirtyPoint = endDirtyPoint = 0;
+		uploads++;
+	}
+}
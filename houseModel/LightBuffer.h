@@ -0,0 +1,104 @@
+#pragma once
+// Std. Includes
+#include <vector>
+
+// GL Includes
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "LightDirectional.h"
+#include "LightPoint.h"
+#include "LightSpot.h"
+#include "UniformBlocks.h"
+
+// std140 layouts of the light structs in FragmentShader.frag, every vec3 shares its 16 bytes with a float
+struct GPUDirLight {
+    glm::vec3 direction;
+    float padding0;
+    glm::vec3 ambient;
+    float padding1;
+    glm::vec3 diffuse;
+    float padding2;
+    glm::vec3 specular;
+    float padding3;
+};
+
+struct GPUPointLight {
+    glm::vec3 position;
+    float constant;
+    glm::vec3 ambient;
+    float linear;
+    glm::vec3 diffuse;
+    float quadratic;
+    glm::vec3 specular;
+    // Slot in PointShadowMaps, negative without shadow
+    float shadowIndex;
+};
+
+struct GPUSpotLight {
+    glm::vec3 position;
+    float innerCutOff;
+    glm::vec3 direction;
+    float outerCutOff;
+    glm::vec3 ambient;
+    float constant;
+    glm::vec3 diffuse;
+    float linear;
+    glm::vec3 specular;
+    float quadratic;
+};
+
+// The Lights block
+struct LightsBlock {
+    GPUDirLight dirLight;
+    GPUSpotLight spotLight;
+    int pointLightCount;
+    int spotLightEnabled;
+    int padding[2];
+};
+
+// Every light of the scene in two uniform buffers: Lights (directional, spot, counts) at
+// LIGHTS_BINDING and the PointLights array at POINT_LIGHTS_BINDING. The shader loops over
+// pointLightCount, so adding lamps needs no shader edit. Setters only mark what changed, update()
+// then writes each changed buffer with one glBufferSubData; static lights cost nothing per frame.
+class LightBuffer {
+    public:
+        // Matches MAX_POINT_LIGHTS in FragmentShader.frag, 64 bytes each fill the 16KB every GL 3.3
+        // implementation guarantees for a uniform block
+        static const unsigned int MAX_POINT_LIGHTS = 256;
+
+        LightBuffer();
+        ~LightBuffer();
+
+        void setDirectional(const LightDirectional& light);
+        void setSpot(const LightSpot& light);
+        void disableSpot();
+        // Returns the index setPoint takes, lights past MAX_POINT_LIGHTS are dropped (returns MAX_POINT_LIGHTS)
+        unsigned int addPoint(const LightPoint& light);
+        void setPoint(unsigned int index, const LightPoint& light);
+        void clearPoints();
+        unsigned int pointCount() const { return (unsigned int)pointLights.size(); }
+        // Packed point lights as the shader sees them, indexed like addPoint returns
+        const std::vector<GPUPointLight>& points() const { return pointLights; }
+        // A point light as the shader sees it
+        static GPUPointLight pack(const LightPoint& light);
+
+        // Writes the buffers whose lights changed since the last update
+        void update();
+
+        // Statistics, buffer writes issued by update()
+        unsigned int uploads;
+
+    private:
+        LightBuffer(const LightBuffer&);
+        LightBuffer& operator=(const LightBuffer&);
+
+        void markPointDirty(unsigned int index);
+
+        LightsBlock lights;
+        std::vector<GPUPointLight> pointLights;
+        bool lightsDirty;
+        // Point lights [firstDirtyPoint, endDirtyPoint) need a write
+        unsigned int firstDirtyPoint, endDirtyPoint;
+        GLuint lightsUBO, pointLightsUBO;
+};
@@ -0,0 +1,213 @@
+#include "LightClusters.h"
+// Std. Includes
+#include <vector>
+#include <cmath>
+#include <cfloat>
+#include <algorithm>
+
+// GL Includes
+#include <glm/gtc/matrix_transform.hpp>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define LIGHT_CLUSTERS_SSE
+#include <xmmintrin.h>
+#endif
+
+LightClusters::LightClusters()
+	: lightIndexCount(0), maxLightsPerCluster(0), projection(0.0f), nearPlane(0.0f), farPlane(0.0f), width(0), height(0),
+	minX(CLUSTER_COUNT), minY(CLUSTER_COUNT), minZ(CLUSTER_COUNT), maxX(CLUSTER_COUNT), maxY(CLUSTER_COUNT), maxZ(CLUSTER_COUNT),
+	grid(2 * CLUSTER_COUNT, 0)
+{
+	glGenBuffers(1, &gridBuffer);
+	glGenBuffers(1, &indexBuffer);
+	glGenTextures(1, &gridTexture);
+	glGenTextures(1, &indexTexture);
+	upload();
+	glBindTexture(GL_TEXTURE_BUFFER, gridTexture);
+	glTexBuffer(GL_TEXTURE_BUFFER, GL_RG32UI, gridBuffer);
+	glBindTexture(GL_TEXTURE_BUFFER, indexTexture);
+	glTexBuffer(GL_TEXTURE_BUFFER, GL_R32UI, indexBuffer);
+	glBindTexture(GL_TEXTURE_BUFFER, 0);
+}
+
+LightClusters::~LightClusters()
+{
+	glDeleteTextures(1, &gridTexture);
+	glDeleteTextures(1, &indexTexture);
+	glDeleteBuffers(1, &gridBuffer);
+	glDeleteBuffers(1, &indexBuffer);
+}
+
+void LightClusters::setProjection(const glm::mat4& projection, float nearPlane, float farPlane, unsigned int width, unsigned int height)
+{
+	if (projection == this->projection && nearPlane == this->nearPlane && farPlane == this->farPlane && width == this->width && height == this->height)
+		return;
+	this->projection = projection;
+	this->nearPlane = nearPlane;
+	this->farPlane = farPlane;
+	this->width = width;
+	this->height = height;
+
+	// Rays through the tile corners, scaled to unit view depth
+	glm::mat4 inverseProjection = glm::inverse(projection);
+	std::vector<glm::vec3> rays((CLUSTER_GRID_X + 1) * (CLUSTER_GRID_Y + 1));
+	for (unsigned int y = 0; y <= CLUSTER_GRID_Y; y++)
+		for (unsigned int x = 0; x <= CLUSTER_GRID_X; x++)
+		{
+			glm::vec4 corner = inverseProjection * glm::vec4(-1.0f + 2.0f * x / CLUSTER_GRID_X, -1.0f + 2.0f * y / CLUSTER_GRID_Y, -1.0f, 1.0f);
+			glm::vec3 point = glm::vec3(corner) / corner.w;
+			rays[x + y * (CLUSTER_GRID_X + 1)] = point / -point.z;
+		}
+
+	for (unsigned int z = 0; z < CLUSTER_GRID_Z; z++)
+	{
+		float sliceNear = nearPlane * std::pow(farPlane / nearPlane, (float)z / CLUSTER_GRID_Z);
+		float sliceFar = nearPlane * std::pow(farPlane / nearPlane, (float)(z + 1) / CLUSTER_GRID_Z);
+		for (unsigned int y = 0; y < CLUSTER_GRID_Y; y++)
+			for (unsigned int x = 0; x < CLUSTER_GRID_X; x++)
+			{
+				glm::vec3 low(FLT_MAX), high(-FLT_MAX);
+				for (unsigned int corner = 0; corner < 4; corner++)
+				{
+					const glm::vec3& ray = rays[(x + (corner & 1)) + (y + (corner >> 1)) * (CLUSTER_GRID_X + 1)];
+					low = glm::min(low, glm::min(ray * sliceNear, ray * sliceFar));
+					high = glm::max(high, glm::max(ray * sliceNear, ray * sliceFar));
+				}
+				unsigned int cluster = x + CLUSTER_GRID_X * (y + CLUSTER_GRID_Y * z);
+				minX[cluster] = low.x;
+				minY[cluster] = low.y;
+				minZ[cluster] = low.z;
+				maxX[cluster] = high.x;
+				maxY[cluster] = high.y;
+				maxZ[cluster] = high.z;
+			}
+	}
+}
+
+float LightClusters::lightRange(const GPUPointLight& light)
+{
+	glm::vec3 brightest = glm::max(light.ambient, glm::max(light.diffuse, light.specular));
+	float threshold = std::max(brightest.x, std::max(brightest.y, brightest.z)) * 256.0f;
+	// Solve constant + linear * d + quadratic * d^2 = threshold
+	if (threshold <= light.constant)
+		return 0.0f;
+	if (light.quadratic > 0.0f)
+		return (-light.linear + std::sqrt(light.linear * light.linear - 4.0f * light.quadratic * (light.constant - threshold))) / (2.0f * light.quadratic);
+	if (light.linear > 0.0f)
+		return (threshold - light.constant) / light.linear;
+	return FLT_MAX;
+}
+
+void LightClusters::assign(const glm::mat4& view, const std::vector<GPUPointLight>& lights)
+{
+	overlapCluster.clear();
+	overlapLight.clear();
+	float logDepthRatio = std::log(farPlane / nearPlane);
+	for (unsigned int light = 0; light < lights.size(); light++)
+	{
+		float radius = lightRange(lights[light]);
+		if (radius <= 0.0f)
+			continue;
+		glm::vec3 center = glm::vec3(view * glm::vec4(lights[light].position, 1.0f));
+		// Depth slices the sphere spans
+		float depthNear = -center.z - radius;
+		float depthFar = -center.z + radius;
+		if (depthFar < nearPlane || depthNear > farPlane)
+			continue;
+		unsigned int firstSlice = 0, lastSlice = CLUSTER_GRID_Z - 1;
+		if (depthNear > nearPlane)
+			firstSlice = std::min((unsigned int)(std::log(depthNear / nearPlane) / logDepthRatio * CLUSTER_GRID_Z), CLUSTER_GRID_Z - 1);
+		if (depthFar < farPlane)
+			lastSlice = std::min((unsigned int)(std::log(depthFar / nearPlane) / logDepthRatio * CLUSTER_GRID_Z), CLUSTER_GRID_Z - 1);
+
+		unsigned int first = CLUSTER_GRID_X * CLUSTER_GRID_Y * firstSlice;
+		unsigned int end = CLUSTER_GRID_X * CLUSTER_GRID_Y * (lastSlice + 1);
+		float radiusSquared = radius == FLT_MAX ? FLT_MAX : radius * radius;
+#ifdef LIGHT_CLUSTERS_SSE
+		// CLUSTER_GRID_X is a multiple of 4, so batches never straddle a row
+		__m128 zero = _mm_setzero_ps();
+		__m128 cx = _mm_set1_ps(center.x), cy = _mm_set1_ps(center.y), cz = _mm_set1_ps(center.z);
+		__m128 r2 = _mm_set1_ps(radiusSquared);
+		for (unsigned int cluster = first; cluster < end; cluster += 4)
+		{
+			// Distance from the center to each box, 0 inside
+			__m128 dx = _mm_add_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&minX[cluster]), cx), zero), _mm_max_ps(_mm_sub_ps(cx, _mm_loadu_ps(&maxX[cluster])), zero));
+			__m128 dy = _mm_add_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&minY[cluster]), cy), zero), _mm_max_ps(_mm_sub_ps(cy, _mm_loadu_ps(&maxY[cluster])), zero));
+			__m128 dz = _mm_add_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&minZ[cluster]), cz), zero), _mm_max_ps(_mm_sub_ps(cz, _mm_loadu_ps(&maxZ[cluster])), zero));
+			__m128 distanceSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+			int hits = _mm_movemask_ps(_mm_cmple_ps(distanceSquared, r2));
+			for (unsigned int lane = 0; hits; lane++, hits >>= 1)
+				if (hits & 1)
+				{
+					overlapCluster.push_back(cluster + lane);
+					overlapLight.push_back(light);
+				}
+		}
+#else
+		for (unsigned int cluster = first; cluster < end; cluster++)
+		{
+			float dx = std::max(minX[cluster] - center.x, 0.0f) + std::max(center.x - maxX[cluster], 0.0f);
+			float dy = std::max(minY[cluster] - center.y, 0.0f) + std::max(center.y - maxY[cluster], 0.0f);
+			float dz = std::max(minZ[cluster] - center.z, 0.0f) + std::max(center.z - maxZ[cluster], 0.0f);
+			if (dx * dx + dy * dy + dz * dz <= radiusSquared)
+			{
+				overlapCluster.push_back(cluster);
+				overlapLight.push_back(light);
+			}
+		}
+#endif
+	}
+
+	// Counting sort by cluster, lights stay in ascending order within a cluster
+	std::fill(grid.begin(), grid.end(), 0);
+	for (unsigned int i = 0; i < overlapCluster.size(); i++)
+		grid[2 * overlapCluster[i] + 1]++;
+	GLuint offset = 0;
+	maxLightsPerCluster = 0;
+	for (unsigned int cluster = 0; cluster < CLUSTER_COUNT; cluster++)
+	{
+		grid[2 * cluster] = offset;
+		offset += grid[2 * cluster + 1];
+		maxLightsPerCluster = std::max(maxLightsPerCluster, (unsigned int)grid[2 * cluster + 1]);
+		grid[2 * cluster + 1] = 0;
+	}
+	lightIndices.resize(overlapCluster.size());
+	for (unsigned int i = 0; i < overlapCluster.size(); i++)
+	{
+		GLuint* cell = &grid[2 * overlapCluster[i]];
+		lightIndices[cell[0] + cell[1]++] = overlapLight[i];
+	}
+	lightIndexCount = (unsigned int)lightIndices.size();
+}
+
+void LightClusters::build(const glm::mat4& view, const LightBuffer& lights)
+{
+	assign(view, lights.points());
+	upload();
+}
+
+void LightClusters::upload()
+{
+	// Orphan and refill, the lists change every frame the camera moves
+	glBindBuffer(GL_TEXTURE_BUFFER, gridBuffer);
+	glBufferData(GL_TEXTURE_BUFFER, grid.size() * sizeof(GLuint), grid.data(), GL_STREAM_DRAW);
+	glBindBuffer(GL_TEXTURE_BUFFER, indexBuffer);
+	// Never empty, a texture buffer needs storage
+	glBufferData(GL_TEXTURE_BUFFER, std::max<size_t>(lightIndices.size(), 1) * sizeof(GLuint), lightIndices.empty() ? NULL : lightIndices.data(), GL_STREAM_DRAW);
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+void LightClusters::bind(const Shader& shader) const
+{
+	glActiveTexture(GL_TEXTURE0 + CLUSTER_GRID_UNIT);
+	glBindTexture(GL_TEXTURE_BUFFER, gridTexture);
+	glActiveTexture(GL_TEXTURE0 + CLUSTER_LIGHTS_UNIT);
+	glBindTexture(GL_TEXTURE_BUFFER, indexTexture);
+	glActiveTexture(GL_TEXTURE0);
+	shader.setInt("clusterGrid", CLUSTER_GRID_UNIT);
+	shader.setInt("clusterLights", CLUSTER_LIGHTS_UNIT);
+	// Fragment -> cluster: tile from gl_FragCoord, slice = log(depth) * scale + bias
+	float logDepthRatio = std::log(farPlane / nearPlane);
+	shader.uniform<glm::vec2>("clusterTileSize").set(glm::vec2((float)width / CLUSTER_GRID_X, (float)height / CLUSTER_GRID_Y));
+	shader.uniform<glm::vec2>("clusterDepthScaleBias").set(glm::vec2(CLUSTER_GRID_Z / logDepthRatio, -CLUSTER_GRID_Z * std::log(nearPlane) / logDepthRatio));
+}
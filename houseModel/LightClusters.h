@@ -0,0 +1,64 @@
+#pragma once
+// Std. Includes
+#include <vector>
+
+// GL Includes
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "LightBuffer.h"
+#include "Shader.h"
+
+// Froxel grid of the view frustum: screen tiles times exponentially spaced depth slices
+const unsigned int CLUSTER_GRID_X = 16;
+const unsigned int CLUSTER_GRID_Y = 9;
+const unsigned int CLUSTER_GRID_Z = 24;
+const unsigned int CLUSTER_COUNT = CLUSTER_GRID_X * CLUSTER_GRID_Y * CLUSTER_GRID_Z;
+
+// Texture units of the cluster buffers, above the material samplers Mesh binds
+const unsigned int CLUSTER_GRID_UNIT = 8;
+const unsigned int CLUSTER_LIGHTS_UNIT = 9;
+
+// Clustered forward lighting. Every froxel gets the list of point lights whose range touches it, and
+// FragmentShader.frag only evaluates the lights of its fragment's froxel instead of all of them.
+// The lists are built on the CPU each frame, testing light spheres against four cluster AABBs at a
+// time with SSE. They reach the shader through two texture buffers (GL 3.1): (offset, count) per
+// cluster into one flat list of light indices.
+class LightClusters {
+    public:
+        LightClusters();
+        ~LightClusters();
+
+        // Recomputes the view space cluster bounds, only when projection or viewport changed
+        void setProjection(const glm::mat4& projection, float nearPlane, float farPlane, unsigned int width, unsigned int height);
+        // Bins the point lights for this view (assign) and uploads the lists
+        void build(const glm::mat4& view, const LightBuffer& lights);
+        void assign(const glm::mat4& view, const std::vector<GPUPointLight>& lights);
+        // Binds the buffers and sets the grid uniforms, the shader has to be in use
+        void bind(const Shader& shader) const;
+
+        // Distance at which the light's attenuated intensity drops below 1/256, it is ignored beyond
+        static float lightRange(const GPUPointLight& light);
+
+        // Statistics of the last assign
+        unsigned int lightIndexCount;
+        unsigned int maxLightsPerCluster;
+
+    private:
+        LightClusters(const LightClusters&);
+        LightClusters& operator=(const LightClusters&);
+
+        void upload();
+
+        glm::mat4 projection;
+        float nearPlane, farPlane;
+        unsigned int width, height;
+        // View space AABB of every cluster (x + X * (y + Y * z)), as separate arrays for the SSE test
+        std::vector<float> minX, minY, minZ, maxX, maxY, maxZ;
+        // (offset, count) per cluster and the lists they point into
+        std::vector<GLuint> grid;
+        std::vector<GLuint> lightIndices;
+        // Scratch of assign: every (cluster, light) overlap in light order
+        std::vector<unsigned int> overlapCluster, overlapLight;
+        GLuint gridBuffer, gridTexture, indexBuffer, indexTexture;
+};
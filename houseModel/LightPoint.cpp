@@ -7,7 +7,9 @@ LightPoint::LightPoint(glm::vec3 _position, glm::vec3 _ambient, glm::vec3 _diffu
 	specular(_specular),
 	constant(_constant),
 	linear(_linear),
-	quadratic(_quadratic)
+	quadratic(_quadratic),
+	shadowIndex(-1),
+	shadowPriority(1.0f)
 {
 }
 
@@ -18,6 +20,8 @@ LightPoint::LightPoint(glm::vec3 _position, float _ambient, float _diffuse, floa
 	specular(_specular, _specular, _specular),
 	constant(_constant),
 	linear(_linear),
-	quadratic(_quadratic)
+	quadratic(_quadratic),
+	shadowIndex(-1),
+	shadowPriority(1.0f)
 {
 }
@@ -14,6 +14,10 @@ public:
 	float constant;
 	float linear;
 	float quadratic;
+	// Slot in PointShadowMaps, -1 casts no shadow
+	int shadowIndex;
+	// Scales the shadow tile size PointShadowMaps picks for the light, 1 by default
+	float shadowPriority;
 
 	LightPoint(glm::vec3 _position, glm::vec3 _ambient, glm::vec3 _diffuse, glm::vec3 _specular, float _constant = 1.0f, float _linear = 0.09f, float _quadratic = 0.032f);
 	LightPoint(glm::vec3 _position, float _ambient, float _diffuse, float _specular, float _constant = 1.0f, float _linear = 0.09f, float _quadratic = 0.032f);
@@ -0,0 +1,29 @@
+#include "LightSpot.h"
+
+LightSpot::LightSpot(glm::vec3 _position, glm::vec3 _direction, float _innerCutOff, float _outerCutOff, glm::vec3 _ambient, glm::vec3 _diffuse, glm::vec3 _specular, float _constant, float _linear, float _quadratic):
+	position(_position),
+	direction(_direction),
+	innerCutOff(_innerCutOff),
+	outerCutOff(_outerCutOff),
+	ambient(_ambient),
+	diffuse(_diffuse),
+	specular(_specular),
+	constant(_constant),
+	linear(_linear),
+	quadratic(_quadratic)
+{
+}
+
+LightSpot::LightSpot(glm::vec3 _position, glm::vec3 _direction, float _innerCutOff, float _outerCutOff, float _ambient, float _diffuse, float _specular, float _constant, float _linear, float _quadratic):
+	position(_position),
+	direction(_direction),
+	innerCutOff(_innerCutOff),
+	outerCutOff(_outerCutOff),
+	ambient(_ambient, _ambient, _ambient),
+	diffuse(_diffuse, _diffuse, _diffuse),
+	specular(_specular, _specular, _specular),
+	constant(_constant),
+	linear(_linear),
+	quadratic(_quadratic)
+{
+}
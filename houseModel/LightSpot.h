@@ -0,0 +1,23 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+class LightSpot
+{
+public:
+	glm::vec3 position;
+	glm::vec3 direction; // the direction that light source points to
+	float innerCutOff; // cosines of the cone angles, full intensity inside innerCutOff
+	float outerCutOff;
+	glm::vec3 ambient;
+	glm::vec3 diffuse;
+	glm::vec3 specular;
+	float constant;
+	float linear;
+	float quadratic;
+
+	LightSpot(glm::vec3 _position, glm::vec3 _direction, float _innerCutOff, float _outerCutOff, glm::vec3 _ambient, glm::vec3 _diffuse, glm::vec3 _specular, float _constant = 1.0f, float _linear = 0.09f, float _quadratic = 0.032f);
+	LightSpot(glm::vec3 _position, glm::vec3 _direction, float _innerCutOff, float _outerCutOff, float _ambient, float _diffuse, float _specular, float _constant = 1.0f, float _linear = 0.09f, float _quadratic = 0.032f);
+};
@@ -0,0 +1,276 @@
+#include "MeshArena.h"
+// Std. Includes
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <cstring>
+
+FreeList::FreeList(unsigned int capacity) : size(0)
+{
+	grow(capacity);
+}
+
+bool FreeList::allocate(unsigned int length, unsigned int& offset)
+{
+	if (length == 0)
+	{
+		offset = 0;
+		return true;
+	}
+	for (std::map<unsigned int, unsigned int>::iterator it = ranges.begin(); it != ranges.end(); ++it)
+	{
+		if (it->second < length)
+			continue;
+		offset = it->first;
+		unsigned int remaining = it->second - length;
+		ranges.erase(it);
+		if (remaining > 0)
+			ranges[offset + length] = remaining;
+		return true;
+	}
+	return false;
+}
+
+void FreeList::release(unsigned int offset, unsigned int length)
+{
+	if (length == 0)
+		return;
+	std::map<unsigned int, unsigned int>::iterator next = ranges.lower_bound(offset);
+	// Merge with the free range right after it
+	if (next != ranges.end() && offset + length == next->first)
+	{
+		length += next->second;
+		next = ranges.erase(next);
+	}
+	// and with the one right before it
+	if (next != ranges.begin())
+	{
+		std::map<unsigned int, unsigned int>::iterator previous = next;
+		--previous;
+		if (previous->first + previous->second == offset)
+		{
+			previous->second += length;
+			return;
+		}
+	}
+	ranges[offset] = length;
+}
+
+void FreeList::grow(unsigned int newCapacity)
+{
+	if (newCapacity <= size)
+		return;
+	unsigned int oldCapacity = size;
+	size = newCapacity;
+	release(oldCapacity, newCapacity - oldCapacity);
+}
+
+void FreeList::reset(unsigned int newCapacity, unsigned int used)
+{
+	ranges.clear();
+	size = newCapacity;
+	if (used < newCapacity)
+		ranges[used] = newCapacity - used;
+}
+
+unsigned int FreeList::freeElements() const
+{
+	unsigned int total = 0;
+	for (std::map<unsigned int, unsigned int>::const_iterator it = ranges.begin(); it != ranges.end(); ++it)
+		total += it->second;
+	return total;
+}
+
+MeshArena::MeshArena(VertexFormat format, unsigned int vertexCapacity, unsigned int indexCapacity)
+	: usedVertices(0), usedIndices(0), defragmentations(0), vertexFormat(format), vertexSize(VertexLayout::get(format).stride),
+	positionSize(VertexLayout::positions(format).stride), vertexRanges(vertexCapacity), indexRanges(indexCapacity), relocations(0)
+{
+	glGenVertexArrays(1, &VAO);
+	glGenVertexArrays(1, &depthVAO);
+	createBuffers(vertexCapacity, indexCapacity, VBO, positionVBO, EBO);
+	bindLayout();
+}
+
+MeshArena::~MeshArena()
+{
+	glDeleteVertexArrays(1, &VAO);
+	glDeleteVertexArrays(1, &depthVAO);
+	glDeleteBuffers(1, &VBO);
+	glDeleteBuffers(1, &positionVBO);
+	glDeleteBuffers(1, &EBO);
+}
+
+void MeshArena::createBuffers(unsigned int vertexCapacity, unsigned int indexCapacity, GLuint& vbo, GLuint& positionVbo, GLuint& ebo) const
+{
+	glGenBuffers(1, &vbo);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, vbo);
+	glBufferData(GL_COPY_WRITE_BUFFER, (GLsizeiptr)vertexCapacity * vertexSize, 0, GL_STATIC_DRAW);
+	glGenBuffers(1, &positionVbo);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, positionVbo);
+	glBufferData(GL_COPY_WRITE_BUFFER, (GLsizeiptr)vertexCapacity * positionSize, 0, GL_STATIC_DRAW);
+	glGenBuffers(1, &ebo);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, ebo);
+	glBufferData(GL_COPY_WRITE_BUFFER, (GLsizeiptr)indexCapacity * sizeof(unsigned int), 0, GL_STATIC_DRAW);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+// Points both VAOs at the current buffers
+void MeshArena::bindLayout()
+{
+	glBindVertexArray(VAO);
+	glBindBuffer(GL_ARRAY_BUFFER, VBO);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+	const VertexLayout& layout = VertexLayout::get(vertexFormat);
+	for (unsigned int i = 0; i < layout.attributeCount; i++)
+	{
+		const VertexAttribute& attribute = layout.attributes[i];
+		glEnableVertexAttribArray(attribute.location);
+		glVertexAttribPointer(attribute.location, attribute.size, attribute.type, attribute.normalized, layout.stride, (void*)(size_t)attribute.offset);
+	}
+	glBindVertexArray(depthVAO);
+	glBindBuffer(GL_ARRAY_BUFFER, positionVBO);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+	const VertexLayout& positionLayout = VertexLayout::positions(vertexFormat);
+	const VertexAttribute& position = positionLayout.attributes[0];
+	glEnableVertexAttribArray(position.location);
+	glVertexAttribPointer(position.location, position.size, position.type, position.normalized, positionLayout.stride, (void*)(size_t)position.offset);
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+unsigned int MeshArena::allocate(const void* vertexData, unsigned int vertexCount, const unsigned int* indexData, unsigned int indexCount)
+{
+	Allocation allocation = Allocation();
+	allocation.vertexCount = vertexCount;
+	allocation.indexCount = indexCount;
+	allocation.live = true;
+	bool vertexFits = vertexRanges.allocate(vertexCount, allocation.baseVertex);
+	bool indexFits = vertexFits && indexRanges.allocate(indexCount, allocation.firstIndex);
+	if (!indexFits)
+	{
+		// Nothing half allocated may survive the relocation below
+		if (vertexFits)
+			vertexRanges.release(allocation.baseVertex, vertexCount);
+		unsigned int vertexCapacity = vertexRanges.capacity();
+		unsigned int indexCapacity = indexRanges.capacity();
+		bool compactionIsEnough = vertexRanges.freeElements() >= vertexCount && indexRanges.freeElements() >= indexCount;
+		if (compactionIsEnough)
+		{
+			defragment();
+		}
+		else
+		{
+			while (vertexCapacity - usedVertices < vertexCount)
+				vertexCapacity = std::max(vertexCapacity * 2, 1024u);
+			while (indexCapacity - usedIndices < indexCount)
+				indexCapacity = std::max(indexCapacity * 2, 1024u);
+			relocate(vertexCapacity, indexCapacity);
+		}
+		vertexRanges.allocate(vertexCount, allocation.baseVertex);
+		indexRanges.allocate(indexCount, allocation.firstIndex);
+	}
+
+	// Both layouts start every vertex with its position, so the packed stream is a strided copy
+	std::vector<unsigned char> positions((size_t)vertexCount * positionSize);
+	const unsigned char* vertexBytes = static_cast<const unsigned char*>(vertexData);
+	for (unsigned int i = 0; i < vertexCount; i++)
+		memcpy(&positions[(size_t)i * positionSize], vertexBytes + (size_t)i * vertexSize, positionSize);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, VBO);
+	glBufferSubData(GL_COPY_WRITE_BUFFER, (GLintptr)allocation.baseVertex * vertexSize, (GLsizeiptr)vertexCount * vertexSize, vertexData);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, positionVBO);
+	glBufferSubData(GL_COPY_WRITE_BUFFER, (GLintptr)allocation.baseVertex * positionSize, (GLsizeiptr)vertexCount * positionSize, positions.data());
+	glBindBuffer(GL_COPY_WRITE_BUFFER, EBO);
+	glBufferSubData(GL_COPY_WRITE_BUFFER, (GLintptr)allocation.firstIndex * sizeof(unsigned int), (GLsizeiptr)indexCount * sizeof(unsigned int), indexData);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	usedVertices += vertexCount;
+	usedIndices += indexCount;
+
+	unsigned int handle;
+	if (!freeHandles.empty())
+	{
+		handle = freeHandles.back();
+		freeHandles.pop_back();
+		allocations[handle] = allocation;
+	}
+	else
+	{
+		handle = (unsigned int)allocations.size();
+		allocations.push_back(allocation);
+	}
+	return handle;
+}
+
+void MeshArena::release(unsigned int handle)
+{
+	Allocation& allocation = allocations[handle];
+	if (!allocation.live)
+		return;
+	vertexRanges.release(allocation.baseVertex, allocation.vertexCount);
+	indexRanges.release(allocation.firstIndex, allocation.indexCount);
+	usedVertices -= allocation.vertexCount;
+	usedIndices -= allocation.indexCount;
+	allocation.live = false;
+	freeHandles.push_back(handle);
+}
+
+void MeshArena::defragment()
+{
+	relocate(vertexRanges.capacity(), indexRanges.capacity());
+	defragmentations++;
+}
+
+// Copies every live allocation, packed, into new buffers (glCopyBufferSubData can't move within a buffer)
+void MeshArena::relocate(unsigned int newVertexCapacity, unsigned int newIndexCapacity)
+{
+	GLuint newVBO, newPositionVBO, newEBO;
+	createBuffers(newVertexCapacity, newIndexCapacity, newVBO, newPositionVBO, newEBO);
+	// Keep the current order of the allocations, so packing only ever moves them towards the front
+	std::vector<unsigned int> order;
+	for (unsigned int i = 0; i < allocations.size(); i++)
+	{
+		if (allocations[i].live)
+			order.push_back(i);
+	}
+	std::sort(order.begin(), order.end(), [this](unsigned int a, unsigned int b) { return allocations[a].baseVertex < allocations[b].baseVertex; });
+	// The position stream moves with the interleaved one, same vertex offsets
+	unsigned int vertexEnd = 0;
+	for (unsigned int i = 0; i < order.size(); i++)
+	{
+		Allocation& allocation = allocations[order[i]];
+		if (allocation.vertexCount > 0)
+		{
+			glBindBuffer(GL_COPY_READ_BUFFER, VBO);
+			glBindBuffer(GL_COPY_WRITE_BUFFER, newVBO);
+			glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, (GLintptr)allocation.baseVertex * vertexSize, (GLintptr)vertexEnd * vertexSize, (GLsizeiptr)allocation.vertexCount * vertexSize);
+			glBindBuffer(GL_COPY_READ_BUFFER, positionVBO);
+			glBindBuffer(GL_COPY_WRITE_BUFFER, newPositionVBO);
+			glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, (GLintptr)allocation.baseVertex * positionSize, (GLintptr)vertexEnd * positionSize, (GLsizeiptr)allocation.vertexCount * positionSize);
+		}
+		allocation.baseVertex = vertexEnd;
+		vertexEnd += allocation.vertexCount;
+	}
+	std::sort(order.begin(), order.end(), [this](unsigned int a, unsigned int b) { return allocations[a].firstIndex < allocations[b].firstIndex; });
+	glBindBuffer(GL_COPY_READ_BUFFER, EBO);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, newEBO);
+	unsigned int indexEnd = 0;
+	for (unsigned int i = 0; i < order.size(); i++)
+	{
+		Allocation& allocation = allocations[order[i]];
+		if (allocation.indexCount > 0)
+			glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, (GLintptr)allocation.firstIndex * sizeof(unsigned int), (GLintptr)indexEnd * sizeof(unsigned int), (GLsizeiptr)allocation.indexCount * sizeof(unsigned int));
+		allocation.firstIndex = indexEnd;
+		indexEnd += allocation.indexCount;
+	}
+	vertexRanges.reset(newVertexCapacity, vertexEnd);
+	indexRanges.reset(newIndexCapacity, indexEnd);
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	glDeleteBuffers(1, &VBO);
+	glDeleteBuffers(1, &positionVBO);
+	glDeleteBuffers(1, &EBO);
+	VBO = newVBO;
+	positionVBO = newPositionVBO;
+	EBO = newEBO;
+	relocations++;
+	bindLayout();
+}
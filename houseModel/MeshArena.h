@@ -0,0 +1,90 @@
+#pragma once
+// Std. Includes
+#include <vector>
+#include <map>
+
+// GL Includes
+#include <GL/glew.h>
+
+#include "Mesh.h"
+
+// First fit allocator of element ranges [0, capacity), freed ranges are merged with their neighbours
+class FreeList {
+    public:
+        explicit FreeList(unsigned int capacity = 0);
+        // Returns false when no free range is large enough
+        bool allocate(unsigned int size, unsigned int& offset);
+        void release(unsigned int offset, unsigned int size);
+        // Appends [capacity, newCapacity) as free space
+        void grow(unsigned int newCapacity);
+        // Everything below used is taken, the rest is free (after compaction)
+        void reset(unsigned int newCapacity, unsigned int used);
+        unsigned int capacity() const { return size; }
+        unsigned int freeElements() const;
+
+    private:
+        // offset -> length of every free range
+        std::map<unsigned int, unsigned int> ranges;
+        unsigned int size;
+};
+
+// One VBO/EBO pair with a single VAO that many meshes are suballocated from, so drawing them needs no
+// VAO switch: each mesh is a glDrawElementsBaseVertex of its ranges. A second VBO holds the positions
+// alone, packed at the same vertex offsets, for depth passes through depthVertexArray(). Indices stay relative to their
+// mesh and are 32 bit. When an allocation doesn't fit, the arena defragments if that frees enough
+// contiguous space and grows its buffers otherwise; allocations are addressed by handle because both
+// move them.
+class MeshArena {
+    public:
+        struct Allocation {
+            unsigned int baseVertex;
+            unsigned int vertexCount;
+            unsigned int firstIndex;
+            unsigned int indexCount;
+            bool live;
+        };
+
+        // Capacities in vertices and indices, the buffers grow on demand
+        MeshArena(VertexFormat format, unsigned int vertexCapacity = 65536, unsigned int indexCapacity = 262144);
+        ~MeshArena();
+
+        // vertexData is laid out as VertexLayout::get(format()), returns the handle of the allocation
+        unsigned int allocate(const void* vertexData, unsigned int vertexCount, const unsigned int* indexData, unsigned int indexCount);
+        void release(unsigned int handle);
+        const Allocation& allocation(unsigned int handle) const { return allocations[handle]; }
+        // Packs every live allocation to the front of the buffers
+        void defragment();
+
+        VertexFormat format() const { return vertexFormat; }
+        GLuint vertexArray() const { return VAO; }
+        // Positions only (VertexLayout::positions) sharing the EBO, see Mesh::DrawDepth
+        GLuint depthVertexArray() const { return depthVAO; }
+        // Changes whenever allocations move (defragment or growth), cached offsets are stale then
+        unsigned int generation() const { return relocations; }
+
+        // Statistics
+        unsigned int usedVertices;
+        unsigned int usedIndices;
+        unsigned int defragmentations;
+
+    private:
+        MeshArena(const MeshArena&);
+        MeshArena& operator=(const MeshArena&);
+
+        // Moves every live allocation, packed, into new buffers of the given capacities
+        void relocate(unsigned int newVertexCapacity, unsigned int newIndexCapacity);
+        void createBuffers(unsigned int vertexCapacity, unsigned int indexCapacity, GLuint& vbo, GLuint& positionVbo, GLuint& ebo) const;
+        void bindLayout();
+
+        VertexFormat vertexFormat;
+        unsigned int vertexSize;
+        // Stride of the position stream, the first positionSize bytes of every vertex
+        unsigned int positionSize;
+        GLuint VAO, VBO, EBO;
+        GLuint depthVAO, positionVBO;
+        FreeList vertexRanges;
+        FreeList indexRanges;
+        std::vector<Allocation> allocations;
+        std::vector<unsigned int> freeHandles;
+        unsigned int relocations;
+};
@@ -0,0 +1,39 @@
+#pragma once
+// Std. Includes
+#include <vector>
+
+#include "Mesh.h"
+
+// Post-transform vertex cache size the optimizer targets and measures against
+const unsigned int VERTEX_CACHE_SIZE = 16;
+
+// Import stage reordering of Mesh vertices/indices, run before setUpMesh:
+//  1. triangles for the post-transform vertex cache (Tipsify, Sander et al. 2007)
+//  2. clusters of those triangles for less overdraw (outward facing clusters first), as long as
+//     the cache efficiency stays within overdrawThreshold of step 1
+//  3. vertices in order of first use, for vertex fetch locality
+class MeshOptimizer {
+    public:
+        struct Stats {
+            unsigned int triangles;
+            unsigned int vertices;
+            // vertex shader invocations with a FIFO cache of VERTEX_CACHE_SIZE
+            unsigned int transformsBefore;
+            unsigned int transformsAfter;
+            // average cache miss ratio: transforms per triangle (0.5 is the ideal for large grids, 3 the worst)
+            float acmrBefore() const { return triangles ? (float)transformsBefore / triangles : 0.0f; }
+            float acmrAfter() const { return triangles ? (float)transformsAfter / triangles : 0.0f; }
+            // average transform to vertex ratio (1.0 is the ideal)
+            float atvrBefore() const { return vertices ? (float)transformsBefore / vertices : 0.0f; }
+            float atvrAfter() const { return vertices ? (float)transformsAfter / vertices : 0.0f; }
+        };
+
+        // Runs all three passes on a triangle list
+        static Stats optimize(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices, float overdrawThreshold = 1.05f);
+
+        static void optimizeVertexCache(std::vector<unsigned int>& indices, unsigned int vertexCount, std::vector<unsigned int>* clusters = 0);
+        static void optimizeOverdraw(std::vector<unsigned int>& indices, const std::vector<Vertex>& vertices, const std::vector<unsigned int>& clusters, float threshold);
+        static void optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices);
+        // Vertex shader invocations of an index buffer with a FIFO cache of cacheSize entries
+        static unsigned int countTransforms(const std::vector<unsigned int>& indices, unsigned int vertexCount, unsigned int cacheSize = VERTEX_CACHE_SIZE);
+};
@@ -0,0 +1,131 @@
+#include "MeshWelder.h"
+// Std. Includes
+#include <vector>
+#include <unordered_map>
+#include <thread>
+#include <functional>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+// Vertex attributes snapped to the weld grid, plus their hash
+struct WeldKey {
+	int64_t cells[8];
+	uint64_t hash;
+	bool operator==(const WeldKey& other) const { return std::memcmp(cells, other.cells, sizeof(cells)) == 0; }
+};
+
+struct WeldKeyHash {
+	size_t operator()(const WeldKey& key) const { return (size_t)key.hash; }
+};
+
+static int64_t weldCell(float value, float epsilon)
+{
+	if (epsilon > 0.0f)
+		return (int64_t)std::floor((double)value / epsilon + 0.5);
+	// Exact mode compares bit patterns, with -0 and +0 treated as the same value
+	if (value == 0.0f)
+		return 0;
+	int32_t bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+	return bits;
+}
+
+static WeldKey makeWeldKey(const Vertex& vertex, float epsilon)
+{
+	const float attributes[8] = {
+		vertex.Position.x, vertex.Position.y, vertex.Position.z,
+		vertex.Normal.x, vertex.Normal.y, vertex.Normal.z,
+		vertex.TexCoords.x, vertex.TexCoords.y
+	};
+	WeldKey key;
+	// splitmix64 style mixing, the cells of neighbouring vertices only differ in their low bits
+	key.hash = 0;
+	for (unsigned int i = 0; i < 8; i++)
+	{
+		key.cells[i] = weldCell(attributes[i], epsilon);
+		uint64_t h = key.hash ^ ((uint64_t)key.cells[i] + 0x9e3779b97f4a7c15ULL + (key.hash << 6) + (key.hash >> 2));
+		h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+		h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+		key.hash = h ^ (h >> 31);
+	}
+	return key;
+}
+
+// Runs task(0..threadCount-1), task 0 on the calling thread
+static void runOnThreads(unsigned int threadCount, const std::function<void(unsigned int)>& task)
+{
+	std::vector<std::thread> threads;
+	for (unsigned int t = 1; t < threadCount; t++)
+		threads.push_back(std::thread(task, t));
+	task(0);
+	for (unsigned int t = 0; t < threads.size(); t++)
+		threads[t].join();
+}
+
+MeshWelder::Stats MeshWelder::weld(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices, float epsilon)
+{
+	unsigned int vertexCount = (unsigned int)vertices.size();
+	Stats stats;
+	stats.verticesBefore = vertexCount;
+	stats.verticesAfter = vertexCount;
+	if (vertexCount < 2)
+		return stats;
+
+	unsigned int threadCount = 1;
+	if (vertexCount >= WELD_PARALLEL_THRESHOLD)
+	{
+		threadCount = std::thread::hardware_concurrency();
+		if (threadCount == 0)
+			threadCount = 1;
+		if (threadCount > 8)
+			threadCount = 8;
+	}
+
+	// 1. Snap and hash every vertex, in contiguous chunks
+	std::vector<WeldKey> keys(vertexCount);
+	runOnThreads(threadCount, [&](unsigned int t) {
+		unsigned int begin = (unsigned int)((uint64_t)vertexCount * t / threadCount);
+		unsigned int end = (unsigned int)((uint64_t)vertexCount * (t + 1) / threadCount);
+		for (unsigned int v = begin; v < end; v++)
+			keys[v] = makeWeldKey(vertices[v], epsilon);
+	});
+
+	// 2. Find the first vertex of every group. Equal keys have equal hashes, so partitioning by hash lets
+	//    every thread own a private table; each walks the vertices in order, so the result is deterministic.
+	std::vector<unsigned int> representative(vertexCount);
+	runOnThreads(threadCount, [&](unsigned int t) {
+		std::unordered_map<WeldKey, unsigned int, WeldKeyHash> firstOf;
+		firstOf.reserve(vertexCount / threadCount + 1);
+		for (unsigned int v = 0; v < vertexCount; v++)
+		{
+			if (keys[v].hash % threadCount != t)
+				continue;
+			representative[v] = firstOf.insert(std::make_pair(keys[v], v)).first->second;
+		}
+	});
+
+	// 3. Compact, a representative always comes before the vertices merged into it
+	std::vector<unsigned int> remap(vertexCount);
+	unsigned int welded = 0;
+	for (unsigned int v = 0; v < vertexCount; v++)
+	{
+		if (representative[v] == v)
+		{
+			vertices[welded] = vertices[v];
+			remap[v] = welded++;
+		}
+		else
+		{
+			remap[v] = remap[representative[v]];
+		}
+	}
+	if (welded == vertexCount)
+		return stats;
+	vertices.resize(welded);
+	vertices.shrink_to_fit();
+	for (unsigned int i = 0; i < indices.size(); i++)
+		indices[i] = remap[indices[i]];
+	stats.verticesAfter = welded;
+	return stats;
+}
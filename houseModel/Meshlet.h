@@ -0,0 +1,56 @@
+#pragma once
+// Std. Includes
+#include <vector>
+
+// GL Includes
+#include <glm/glm.hpp>
+
+struct Vertex;
+
+// Cluster size limits, small enough for tight bounds and a useful cone
+const unsigned int MESHLET_MAX_VERTICES = 64;
+const unsigned int MESHLET_MAX_TRIANGLES = 124;
+
+// A contiguous range of a Mesh index buffer with its bounds, all in model space
+struct Meshlet {
+    unsigned int firstIndex;
+    unsigned int indexCount;
+    // Bounding sphere
+    glm::vec3 center;
+    float radius;
+    // Normal cone: every face normal is within the cone around coneAxis, coneCutoff is the sine of its
+    // half angle (1 when the faces spread too far for the cone to reject anything)
+    glm::vec3 coneAxis;
+    float coneCutoff;
+};
+
+// Splits an index buffer (triangle list) into meshlets without reordering it, so a meshlet is drawn
+// by a glDrawElements of its range. Run it on the optimized index order, which already keeps
+// neighbouring triangles together.
+class MeshletBuilder {
+    public:
+        static std::vector<Meshlet> build(const Vertex* vertices, unsigned int vertexCount, const unsigned int* indices, unsigned int indexCount);
+};
+
+// Per draw CPU rejection of meshlets against the view frustum and by their normal cone (all faces
+// pointing away from the camera). The cone test drops back faces, so it is only exact for closed
+// meshes while GL_CULL_FACE is off; set coneCulling to false for two-sided geometry.
+class MeshletCuller {
+    public:
+        // model: the matrix the mesh is drawn with, viewProjection: projection * view
+        MeshletCuller(const glm::mat4& model, const glm::mat4& viewProjection, const glm::vec3& cameraPosition);
+        bool visible(const Meshlet& meshlet);
+
+        bool coneCulling;
+
+        // Statistics, accumulated over every visible() call
+        unsigned int tested;
+        unsigned int frustumCulled;
+        unsigned int coneCulled;
+        unsigned int drawCalls;
+
+    private:
+        // Frustum planes and camera position in model space
+        glm::vec4 planes[6];
+        glm::vec3 camera;
+};
@@ -0,0 +1,215 @@
+#include "PointShadowMaps.h"
+// Std. Includes
+#include <algorithm>
+#include <iostream>
+
+// GL Includes
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "LightBuffer.h"
+#include "LightClusters.h"
+
+// Look direction and up vector of every cube face, the GL cube map conventions
+static const glm::vec3 faceDirections[6] = {
+	glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(-1.0f, 0.0f, 0.0f),
+	glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f),
+	glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 0.0f, -1.0f)
+};
+static const glm::vec3 faceUps[6] = {
+	glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f),
+	glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 0.0f, -1.0f),
+	glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f)
+};
+static const std::string faceMatrixNames[6] = {
+	"shadowFaceMatrices[0]", "shadowFaceMatrices[1]", "shadowFaceMatrices[2]",
+	"shadowFaceMatrices[3]", "shadowFaceMatrices[4]", "shadowFaceMatrices[5]"
+};
+static const std::string faceTileNames[6] = {
+	"shadowFaceTiles[0]", "shadowFaceTiles[1]", "shadowFaceTiles[2]",
+	"shadowFaceTiles[3]", "shadowFaceTiles[4]", "shadowFaceTiles[5]"
+};
+
+// Orders (tile size, slot) requests largest first
+static bool largerTile(const std::pair<unsigned int, int>& a, const std::pair<unsigned int, int>& b)
+{
+	return a.first > b.first;
+}
+
+PointShadowMaps::PointShadowMaps(unsigned int atlasSize, unsigned int maxTile, unsigned int minTile, float farPlane)
+	: farPlane(farPlane), facesDrawn(0), facesCulled(0), lightsPacked(0), lightsDropped(0), texelsPacked(0),
+	atlas(atlasSize, minTile), maxTile(maxTile), minTile(minTile), lightCount(0), lightPosition(0.0f)
+{
+	for (unsigned int i = 0; i < MAX_POINT_SHADOWS * 6; i++)
+	{
+		tiles[i] = glm::vec4(0.0f);
+		tileNames.push_back("pointShadowTiles[" + std::to_string(i) + "]");
+	}
+
+	glGenTextures(1, &depthMap);
+	glBindTexture(GL_TEXTURE_2D, depthMap);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, atlasSize, atlasSize, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	glGenFramebuffers(1, &framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthMap, 0);
+	glDrawBuffer(GL_NONE);
+	glReadBuffer(GL_NONE);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		std::cout << "ERROR::POINT_SHADOW::FRAMEBUFFER_INCOMPLETE" << std::endl;
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+PointShadowMaps::~PointShadowMaps()
+{
+	glDeleteFramebuffers(1, &framebuffer);
+	glDeleteTextures(1, &depthMap);
+}
+
+bool PointShadowMaps::assign(LightPoint& light)
+{
+	if (lightCount >= MAX_POINT_SHADOWS)
+	{
+		light.shadowIndex = -1;
+		return false;
+	}
+	light.shadowIndex = (int)lightCount++;
+	return true;
+}
+
+void PointShadowMaps::pack(const std::vector<const LightPoint*>& lights, const glm::vec3& viewPosition, const glm::mat4& projection)
+{
+	for (unsigned int i = 0; i < lightCount * 6; i++)
+		tiles[i] = glm::vec4(0.0f);
+
+	// Wanted face size of every light: a light the camera is inside of covers the whole screen, further
+	// away it shrinks with its projected range
+	std::vector<std::pair<unsigned int, int> > requests;
+	for (unsigned int i = 0; i < lights.size(); i++)
+	{
+		const LightPoint& light = *lights[i];
+		if (light.shadowIndex < 0 || light.shadowIndex >= (int)lightCount)
+			continue;
+		float range = std::min(LightClusters::lightRange(LightBuffer::pack(light)), farPlane);
+		float distance = glm::length(light.position - viewPosition);
+		float coverage = distance <= range ? 1.0f : std::min(1.0f, range * projection[1][1] / distance);
+		float wanted = maxTile * coverage * light.shadowPriority;
+		unsigned int size = maxTile;
+		while (size > minTile && size / 2 >= wanted)
+			size /= 2;
+		requests.push_back(std::make_pair(size, light.shadowIndex));
+	}
+	// Largest first, so the quadtree never fragments
+	std::sort(requests.begin(), requests.end(), largerTile);
+
+	atlas.clear();
+	lightsPacked = 0;
+	lightsDropped = 0;
+	// Once a light had to shrink, the ones after it get no more, which keeps the order descending
+	unsigned int cap = maxTile;
+	float texel = 1.0f / atlas.size();
+	for (unsigned int i = 0; i < requests.size(); i++)
+	{
+		unsigned int size = std::min(requests[i].first, cap);
+		while (size >= minTile && atlas.freeTexels() < 6ull * size * size)
+			size /= 2;
+		if (size < minTile)
+		{
+			lightsDropped++;
+			cap = 0;
+			continue;
+		}
+		cap = size;
+		for (unsigned int face = 0; face < 6; face++)
+		{
+			ShadowTile tile;
+			atlas.allocate(size, tile);
+			tiles[requests[i].second * 6 + face] = glm::vec4(tile.x * texel, tile.y * texel, tile.size * texel, 0.0f);
+		}
+		lightsPacked++;
+	}
+	texelsPacked = atlas.texelsAllocated;
+}
+
+void PointShadowMaps::begin()
+{
+	facesDrawn = 0;
+	facesCulled = 0;
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glViewport(0, 0, atlas.size(), atlas.size());
+	glClear(GL_DEPTH_BUFFER_BIT);
+	// The geometry shader clips every face to the side planes of its frustum so nothing spills into a neighbour tile
+	for (unsigned int plane = 0; plane < 4; plane++)
+		glEnable(GL_CLIP_DISTANCE0 + plane);
+}
+
+bool PointShadowMaps::beginLight(const Shader& shader, const LightPoint& light)
+{
+	if (light.shadowIndex < 0 || light.shadowIndex >= (int)lightCount || tiles[light.shadowIndex * 6].z == 0.0f)
+		return false;
+	lightPosition = light.position;
+	glm::mat4 projection = glm::perspective(glm::radians(90.0f), 1.0f, 0.05f, farPlane);
+	for (unsigned int face = 0; face < 6; face++)
+	{
+		shader.setMat4(faceMatrixNames[face], projection * glm::lookAt(light.position, light.position + faceDirections[face], faceUps[face]));
+		// The tile as a scale and offset of normalized device coordinates
+		const glm::vec4& tile = tiles[light.shadowIndex * 6 + face];
+		shader.setVec4(faceTileNames[face], glm::vec4((tile.x + 0.5f * tile.z) * 2.0f - 1.0f, (tile.y + 0.5f * tile.z) * 2.0f - 1.0f, tile.z, 0.0f));
+	}
+	shader.setVec3("lightPosition", light.position);
+	shader.setFloat("shadowFarPlane", farPlane);
+	return true;
+}
+
+unsigned int PointShadowMaps::faceMask(const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+{
+	glm::vec3 low = boundsMin - lightPosition;
+	glm::vec3 high = boundsMax - lightPosition;
+	unsigned int mask = 0;
+	for (unsigned int face = 0; face < 6; face++)
+	{
+		int axis = face / 2;
+		bool positive = (face & 1) == 0;
+		int side0 = (axis + 1) % 3, side1 = (axis + 2) % 3;
+		// Furthest and nearest reach of the box along the face direction, behind the light or beyond farPlane it is out
+		float reach = positive ? high[axis] : -low[axis];
+		float nearest = positive ? low[axis] : -high[axis];
+		// The face's frustum is |side| <= depth along the direction, each side plane is tested with the
+		// box corner furthest inside it
+		bool visible = reach > 0.0f && nearest < farPlane
+			&& reach - low[side0] >= 0.0f && reach + high[side0] >= 0.0f
+			&& reach - low[side1] >= 0.0f && reach + high[side1] >= 0.0f;
+		if (!visible)
+		{
+			facesCulled++;
+			continue;
+		}
+		mask |= 1u << face;
+		facesDrawn++;
+	}
+	return mask;
+}
+
+void PointShadowMaps::end()
+{
+	for (unsigned int plane = 0; plane < 4; plane++)
+		glDisable(GL_CLIP_DISTANCE0 + plane);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void PointShadowMaps::bind(const Shader& shader) const
+{
+	glActiveTexture(GL_TEXTURE0 + POINT_SHADOWS_UNIT);
+	glBindTexture(GL_TEXTURE_2D, depthMap);
+	glActiveTexture(GL_TEXTURE0);
+	shader.setInt("pointShadowAtlas", POINT_SHADOWS_UNIT);
+	shader.setFloat("pointShadowFarPlane", farPlane);
+	for (unsigned int i = 0; i < lightCount * 6; i++)
+		shader.setVec4(tileNames[i], tiles[i]);
+}
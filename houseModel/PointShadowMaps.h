@@ -0,0 +1,73 @@
+#pragma once
+// Std. Includes
+#include <string>
+#include <vector>
+
+// GL Includes
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "LightPoint.h"
+#include "ShadowAtlas.h"
+#include "Shader.h"
+
+// Texture unit of the point light shadows, above the cascades of CascadedShadowMap.h
+const unsigned int POINT_SHADOWS_UNIT = 11;
+// Lights that can hold a slot, MAX_POINT_SHADOWS in lighting.glsl
+const unsigned int MAX_POINT_SHADOWS = 16;
+
+// Omnidirectional shadows of point lights, all in one depth atlas of fixed size. Every light with a
+// slot (LightPoint::shadowIndex) gets six square tiles, one per cube face in GL order (+X -X +Y -Y
+// +Z -Z), repacked every frame by pack(): the tile size follows how much of the screen the light can
+// reach times LightPoint::shadowPriority, and lights are shrunk (or left unshadowed) once the atlas is
+// full, so adding lamps costs resolution, not memory.
+// Casters are drawn once per light: the geometry shader (pointShadowGeometryShader.gs) sends each
+// triangle to every face in faceMask, moved into the face's tile and clipped to it. Tiles hold
+// distance to the light / farPlane; GL 3.3 has no cube map arrays, lighting.glsl picks the face itself.
+class PointShadowMaps {
+    public:
+        PointShadowMaps(unsigned int atlasSize = 4096, unsigned int maxTile = 512, unsigned int minTile = 64, float farPlane = 10.0f);
+        ~PointShadowMaps();
+
+        // Gives the light the next free slot, false (and shadowIndex -1) when all are taken
+        bool assign(LightPoint& light);
+        // Sizes and places the tiles of the lights with a slot for this frame, lights left out of the
+        // list get none
+        void pack(const std::vector<const LightPoint*>& lights, const glm::vec3& viewPosition, const glm::mat4& projection);
+        // Binds and clears the atlas for rendering
+        void begin();
+        // Sets up the caster pass of one light, shader is the point shadow program and has to be in use.
+        // False when the light has no tiles this frame
+        bool beginLight(const Shader& shader, const LightPoint& light);
+        // Cube faces of the current light a caster with this world AABB reaches, bit i = face i; 0 skips the draw
+        unsigned int faceMask(const glm::vec3& boundsMin, const glm::vec3& boundsMax);
+        // Back to the default framebuffer, the caller restores its viewport
+        void end();
+        // Binds the atlas and sets the sampling uniforms of lighting.glsl, the shader has to be in use
+        void bind(const Shader& shader) const;
+
+        float farPlane;
+
+        // Statistics, faceMask() results since the last begin()
+        unsigned int facesDrawn;
+        unsigned int facesCulled;
+        // Statistics of the last pack(): lights with tiles, lights left without, atlas texels in use
+        unsigned int lightsPacked;
+        unsigned int lightsDropped;
+        unsigned long long texelsPacked;
+
+    private:
+        PointShadowMaps(const PointShadowMaps&);
+        PointShadowMaps& operator=(const PointShadowMaps&);
+
+        ShadowAtlas atlas;
+        unsigned int maxTile, minTile;
+        unsigned int lightCount;
+        GLuint framebuffer, depthMap;
+        // Per slot and face: tile in atlas texture coordinates (x, y, size, 0), size 0 = no tile this frame
+        glm::vec4 tiles[MAX_POINT_SHADOWS * 6];
+        // "pointShadowTiles[i]", built once
+        std::vector<std::string> tileNames;
+        // Position of the light in beginLight
+        glm::vec3 lightPosition;
+};
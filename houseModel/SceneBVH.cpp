@@ -0,0 +1,439 @@
+#include "SceneBVH.h"
+// Std. Includes
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define SCENE_BVH_SSE
+#include <xmmintrin.h>
+#endif
+
+// Centroid bins per axis of the SAH split and the most items a leaf keeps without trying one
+static const unsigned int sahBins = 12;
+static const unsigned int leafItems = 2;
+static const unsigned int maxDepth = 48;
+
+static float surfaceArea(const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+{
+	glm::vec3 extent = glm::max(boundsMax - boundsMin, glm::vec3(0.0f));
+	return 2.0f * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
+}
+
+// Entry and exit distance of the ray in the box (slab test), false when it misses or starts past maxDistance
+static bool rayBox(const glm::vec3& origin, const glm::vec3& inverseDirection, const glm::vec3& boundsMin, const glm::vec3& boundsMax, float maxDistance, float& entry)
+{
+	glm::vec3 t0 = (boundsMin - origin) * inverseDirection;
+	glm::vec3 t1 = (boundsMax - origin) * inverseDirection;
+	glm::vec3 tNear = glm::min(t0, t1);
+	glm::vec3 tFar = glm::max(t0, t1);
+	entry = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+	float exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, maxDistance));
+	return entry <= exit;
+}
+
+SceneBVH::SceneBVH()
+	: nodesVisited(0), trianglesTested(0)
+{
+}
+
+void SceneBVH::itemBounds(const SceneObject& object, Item& item) const
+{
+	const Mesh& mesh = object.model->meshes[item.mesh];
+	transformBounds(object.transform, mesh.boundsMin, mesh.boundsMax, item.boundsMin, item.boundsMax);
+}
+
+void SceneBVH::build(const std::vector<SceneObject>& objects)
+{
+	items.clear();
+	for (unsigned int object = 0; object < objects.size(); object++)
+	{
+		for (unsigned int mesh = 0; mesh < objects[object].model->meshes.size(); mesh++)
+		{
+			Item item;
+			item.object = object;
+			item.mesh = mesh;
+			itemBounds(objects[object], item);
+			items.push_back(item);
+		}
+	}
+	order.resize(items.size());
+	for (unsigned int i = 0; i < order.size(); i++)
+		order[i] = i;
+	itemLeaves.assign(items.size(), 0);
+	nodes.clear();
+	parents.clear();
+	// At most 2n - 1 nodes, reserved so split() can hold references
+	nodes.reserve(std::max<size_t>(1, 2 * items.size()));
+	Node root;
+	root.first = 0;
+	root.count = (unsigned int)items.size();
+	nodes.push_back(root);
+	parents.push_back(0);
+	updateNode(0);
+	split(0, 0);
+}
+
+// Bounds of a node from its items or children
+void SceneBVH::updateNode(unsigned int index)
+{
+	Node& node = nodes[index];
+	if (node.count == 0)
+	{
+		node.boundsMin = glm::min(nodes[node.first].boundsMin, nodes[node.first + 1].boundsMin);
+		node.boundsMax = glm::max(nodes[node.first].boundsMax, nodes[node.first + 1].boundsMax);
+		return;
+	}
+	node.boundsMin = glm::vec3(FLT_MAX);
+	node.boundsMax = glm::vec3(-FLT_MAX);
+	for (unsigned int i = node.first; i < node.first + node.count; i++)
+	{
+		node.boundsMin = glm::min(node.boundsMin, items[order[i]].boundsMin);
+		node.boundsMax = glm::max(node.boundsMax, items[order[i]].boundsMax);
+	}
+}
+
+void SceneBVH::split(unsigned int index, unsigned int depth)
+{
+	unsigned int first = nodes[index].first;
+	unsigned int count = nodes[index].count;
+	for (unsigned int i = first; i < first + count; i++)
+		itemLeaves[order[i]] = index;
+	if (count <= leafItems || depth >= maxDepth)
+		return;
+
+	// Centroid bounds, the bins span them
+	glm::vec3 centroidMin(FLT_MAX), centroidMax(-FLT_MAX);
+	for (unsigned int i = first; i < first + count; i++)
+	{
+		glm::vec3 centroid = (items[order[i]].boundsMin + items[order[i]].boundsMax) * 0.5f;
+		centroidMin = glm::min(centroidMin, centroid);
+		centroidMax = glm::max(centroidMax, centroid);
+	}
+
+	// Cheapest bin boundary over the three axes: area * items on both sides
+	float bestCost = FLT_MAX;
+	int bestAxis = -1;
+	unsigned int bestBin = 0;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		float extent = centroidMax[axis] - centroidMin[axis];
+		if (extent <= 0.0f)
+			continue;
+		float binScale = sahBins / extent;
+		glm::vec3 binMin[sahBins], binMax[sahBins];
+		unsigned int binCount[sahBins];
+		for (unsigned int bin = 0; bin < sahBins; bin++)
+		{
+			binMin[bin] = glm::vec3(FLT_MAX);
+			binMax[bin] = glm::vec3(-FLT_MAX);
+			binCount[bin] = 0;
+		}
+		for (unsigned int i = first; i < first + count; i++)
+		{
+			const Item& item = items[order[i]];
+			float centroid = (item.boundsMin[axis] + item.boundsMax[axis]) * 0.5f;
+			unsigned int bin = std::min(sahBins - 1, (unsigned int)((centroid - centroidMin[axis]) * binScale));
+			binMin[bin] = glm::min(binMin[bin], item.boundsMin);
+			binMax[bin] = glm::max(binMax[bin], item.boundsMax);
+			binCount[bin]++;
+		}
+		// Sweep from the right once, then from the left
+		float rightArea[sahBins];
+		unsigned int rightCount[sahBins];
+		glm::vec3 sweepMin(FLT_MAX), sweepMax(-FLT_MAX);
+		unsigned int sweepCount = 0;
+		for (unsigned int bin = sahBins - 1; bin > 0; bin--)
+		{
+			sweepMin = glm::min(sweepMin, binMin[bin]);
+			sweepMax = glm::max(sweepMax, binMax[bin]);
+			sweepCount += binCount[bin];
+			rightArea[bin] = sweepCount > 0 ? surfaceArea(sweepMin, sweepMax) : 0.0f;
+			rightCount[bin] = sweepCount;
+		}
+		sweepMin = glm::vec3(FLT_MAX);
+		sweepMax = glm::vec3(-FLT_MAX);
+		sweepCount = 0;
+		for (unsigned int bin = 0; bin + 1 < sahBins; bin++)
+		{
+			sweepMin = glm::min(sweepMin, binMin[bin]);
+			sweepMax = glm::max(sweepMax, binMax[bin]);
+			sweepCount += binCount[bin];
+			if (sweepCount == 0 || rightCount[bin + 1] == 0)
+				continue;
+			float cost = sweepCount * surfaceArea(sweepMin, sweepMax) + rightCount[bin + 1] * rightArea[bin + 1];
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				bestAxis = axis;
+				bestBin = bin;
+			}
+		}
+	}
+	// Not splitting costs an intersection per item over the node's area
+	if (bestAxis < 0 || bestCost >= count * surfaceArea(nodes[index].boundsMin, nodes[index].boundsMax))
+		return;
+
+	float binScale = sahBins / (centroidMax[bestAxis] - centroidMin[bestAxis]);
+	unsigned int leftCount = 0;
+	for (unsigned int i = first; i < first + count; i++)
+	{
+		const Item& item = items[order[i]];
+		float centroid = (item.boundsMin[bestAxis] + item.boundsMax[bestAxis]) * 0.5f;
+		if (std::min(sahBins - 1, (unsigned int)((centroid - centroidMin[bestAxis]) * binScale)) <= bestBin)
+			std::swap(order[i], order[first + leftCount++]);
+	}
+
+	unsigned int left = (unsigned int)nodes.size();
+	Node child;
+	child.first = first;
+	child.count = leftCount;
+	nodes.push_back(child);
+	child.first = first + leftCount;
+	child.count = count - leftCount;
+	nodes.push_back(child);
+	parents.push_back(index);
+	parents.push_back(index);
+	nodes[index].first = left;
+	nodes[index].count = 0;
+	updateNode(left);
+	updateNode(left + 1);
+	split(left, depth + 1);
+	split(left + 1, depth + 1);
+}
+
+void SceneBVH::refit(const std::vector<SceneObject>& objects)
+{
+	for (unsigned int i = 0; i < items.size(); i++)
+	{
+		if (!objects[items[i].object].dynamic)
+			continue;
+		itemBounds(objects[items[i].object], items[i]);
+		// Up from the leaf until a node's box stops changing
+		unsigned int node = itemLeaves[i];
+		while (true)
+		{
+			glm::vec3 oldMin = nodes[node].boundsMin, oldMax = nodes[node].boundsMax;
+			updateNode(node);
+			if (node == 0 || (oldMin == nodes[node].boundsMin && oldMax == nodes[node].boundsMax))
+				break;
+			node = parents[node];
+		}
+	}
+}
+
+void SceneBVH::queryFrustum(const glm::vec4 planes[6], std::vector<std::pair<unsigned int, unsigned int> >& result) const
+{
+	nodesVisited = 0;
+	if (items.empty())
+		return;
+	// Node and whether it is known to be inside all planes
+	std::vector<std::pair<unsigned int, bool> > stack;
+	stack.push_back(std::make_pair(0u, false));
+	while (!stack.empty())
+	{
+		unsigned int index = stack.back().first;
+		bool inside = stack.back().second;
+		stack.pop_back();
+		const Node& node = nodes[index];
+		nodesVisited++;
+		if (!inside)
+		{
+			inside = true;
+			bool outside = false;
+			for (int plane = 0; plane < 6 && !outside; plane++)
+			{
+				const glm::vec4& p = planes[plane];
+				// Corners furthest along and against the plane normal
+				glm::vec3 positive(p.x >= 0.0f ? node.boundsMax.x : node.boundsMin.x, p.y >= 0.0f ? node.boundsMax.y : node.boundsMin.y, p.z >= 0.0f ? node.boundsMax.z : node.boundsMin.z);
+				glm::vec3 negative(p.x >= 0.0f ? node.boundsMin.x : node.boundsMax.x, p.y >= 0.0f ? node.boundsMin.y : node.boundsMax.y, p.z >= 0.0f ? node.boundsMin.z : node.boundsMax.z);
+				outside = glm::dot(glm::vec3(p), positive) + p.w < 0.0f;
+				inside = inside && glm::dot(glm::vec3(p), negative) + p.w >= 0.0f;
+			}
+			if (outside)
+				continue;
+		}
+		if (node.count > 0)
+		{
+			for (unsigned int i = node.first; i < node.first + node.count; i++)
+				result.push_back(std::make_pair(items[order[i]].object, items[order[i]].mesh));
+			continue;
+		}
+		// Inside nodes pass their children without another plane test
+		stack.push_back(std::make_pair(node.first, inside));
+		stack.push_back(std::make_pair(node.first + 1, inside));
+	}
+}
+
+// Closest hit of the ray with triangles [firstIndex, firstIndex + indexCount) of the mesh, in the mesh's space
+static void intersectTriangles(const Mesh& mesh, unsigned int firstIndex, unsigned int indexCount, const glm::vec3& origin, const glm::vec3& direction,
+	float& closest, unsigned int& closestTriangle, unsigned int& tested)
+{
+	const std::vector<Vertex>& vertices = mesh.vertices;
+	const std::vector<unsigned int>& indices = mesh.indices;
+	unsigned int first = firstIndex / 3, end = (firstIndex + indexCount) / 3;
+	unsigned int triangle = first;
+	tested += end - first;
+#ifdef SCENE_BVH_SSE
+	// Moller-Trumbore on four triangles per iteration, vertices gathered into structure of arrays
+	const __m128 originX = _mm_set1_ps(origin.x), originY = _mm_set1_ps(origin.y), originZ = _mm_set1_ps(origin.z);
+	const __m128 directionX = _mm_set1_ps(direction.x), directionY = _mm_set1_ps(direction.y), directionZ = _mm_set1_ps(direction.z);
+	const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f), epsilon = _mm_set1_ps(1e-12f);
+	for (; triangle + 4 <= end; triangle += 4)
+	{
+		float v0[3][4], e1[3][4], e2[3][4];
+		for (int lane = 0; lane < 4; lane++)
+		{
+			const glm::vec3& a = vertices[indices[(triangle + lane) * 3]].Position;
+			const glm::vec3& b = vertices[indices[(triangle + lane) * 3 + 1]].Position;
+			const glm::vec3& c = vertices[indices[(triangle + lane) * 3 + 2]].Position;
+			for (int axis = 0; axis < 3; axis++)
+			{
+				v0[axis][lane] = a[axis];
+				e1[axis][lane] = b[axis] - a[axis];
+				e2[axis][lane] = c[axis] - a[axis];
+			}
+		}
+		__m128 e1x = _mm_loadu_ps(e1[0]), e1y = _mm_loadu_ps(e1[1]), e1z = _mm_loadu_ps(e1[2]);
+		__m128 e2x = _mm_loadu_ps(e2[0]), e2y = _mm_loadu_ps(e2[1]), e2z = _mm_loadu_ps(e2[2]);
+		// p = direction x e2, determinant = e1 . p
+		__m128 px = _mm_sub_ps(_mm_mul_ps(directionY, e2z), _mm_mul_ps(directionZ, e2y));
+		__m128 py = _mm_sub_ps(_mm_mul_ps(directionZ, e2x), _mm_mul_ps(directionX, e2z));
+		__m128 pz = _mm_sub_ps(_mm_mul_ps(directionX, e2y), _mm_mul_ps(directionY, e2x));
+		__m128 determinant = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, px), _mm_mul_ps(e1y, py)), _mm_mul_ps(e1z, pz));
+		__m128 valid = _mm_cmpgt_ps(_mm_andnot_ps(_mm_set1_ps(-0.0f), determinant), epsilon);
+		__m128 inverseDeterminant = _mm_div_ps(one, determinant);
+		// s = origin - v0, u = s . p / det
+		__m128 sx = _mm_sub_ps(originX, _mm_loadu_ps(v0[0]));
+		__m128 sy = _mm_sub_ps(originY, _mm_loadu_ps(v0[1]));
+		__m128 sz = _mm_sub_ps(originZ, _mm_loadu_ps(v0[2]));
+		__m128 u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(sx, px), _mm_mul_ps(sy, py)), _mm_mul_ps(sz, pz)), inverseDeterminant);
+		// q = s x e1, v = direction . q / det, t = e2 . q / det
+		__m128 qx = _mm_sub_ps(_mm_mul_ps(sy, e1z), _mm_mul_ps(sz, e1y));
+		__m128 qy = _mm_sub_ps(_mm_mul_ps(sz, e1x), _mm_mul_ps(sx, e1z));
+		__m128 qz = _mm_sub_ps(_mm_mul_ps(sx, e1y), _mm_mul_ps(sy, e1x));
+		__m128 v = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(directionX, qx), _mm_mul_ps(directionY, qy)), _mm_mul_ps(directionZ, qz)), inverseDeterminant);
+		__m128 t = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)), _mm_mul_ps(e2z, qz)), inverseDeterminant);
+		valid = _mm_and_ps(valid, _mm_cmpge_ps(u, zero));
+		valid = _mm_and_ps(valid, _mm_cmpge_ps(v, zero));
+		valid = _mm_and_ps(valid, _mm_cmple_ps(_mm_add_ps(u, v), one));
+		valid = _mm_and_ps(valid, _mm_cmpgt_ps(t, zero));
+		valid = _mm_and_ps(valid, _mm_cmplt_ps(t, _mm_set1_ps(closest)));
+		int hits = _mm_movemask_ps(valid);
+		if (hits == 0)
+			continue;
+		float distances[4];
+		_mm_storeu_ps(distances, t);
+		for (int lane = 0; lane < 4; lane++)
+		{
+			if ((hits >> lane) & 1 && distances[lane] < closest)
+			{
+				closest = distances[lane];
+				closestTriangle = triangle + lane;
+			}
+		}
+	}
+#endif
+	for (; triangle < end; triangle++)
+	{
+		const glm::vec3& a = vertices[indices[triangle * 3]].Position;
+		glm::vec3 e1 = vertices[indices[triangle * 3 + 1]].Position - a;
+		glm::vec3 e2 = vertices[indices[triangle * 3 + 2]].Position - a;
+		glm::vec3 p = glm::cross(direction, e2);
+		float determinant = glm::dot(e1, p);
+		if (std::fabs(determinant) <= 1e-12f)
+			continue;
+		float inverseDeterminant = 1.0f / determinant;
+		glm::vec3 s = origin - a;
+		float u = glm::dot(s, p) * inverseDeterminant;
+		glm::vec3 q = glm::cross(s, e1);
+		float v = glm::dot(direction, q) * inverseDeterminant;
+		float t = glm::dot(e2, q) * inverseDeterminant;
+		if (u >= 0.0f && v >= 0.0f && u + v <= 1.0f && t > 0.0f && t < closest)
+		{
+			closest = t;
+			closestTriangle = triangle;
+		}
+	}
+}
+
+bool SceneBVH::pick(const std::vector<SceneObject>& objects, const glm::vec3& origin, const glm::vec3& direction, PickResult& result) const
+{
+	nodesVisited = 0;
+	trianglesTested = 0;
+	if (items.empty())
+		return false;
+	glm::vec3 inverseDirection(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+	float closest = FLT_MAX;
+	bool hit = false;
+	std::vector<unsigned int> stack;
+	stack.push_back(0);
+	while (!stack.empty())
+	{
+		unsigned int index = stack.back();
+		stack.pop_back();
+		const Node& node = nodes[index];
+		nodesVisited++;
+		float entry;
+		if (!rayBox(origin, inverseDirection, node.boundsMin, node.boundsMax, closest, entry))
+			continue;
+		if (node.count == 0)
+		{
+			// Nearer child last, so it is visited first and shrinks closest for the other
+			float leftEntry = FLT_MAX, rightEntry = FLT_MAX;
+			bool leftHit = rayBox(origin, inverseDirection, nodes[node.first].boundsMin, nodes[node.first].boundsMax, closest, leftEntry);
+			bool rightHit = rayBox(origin, inverseDirection, nodes[node.first + 1].boundsMin, nodes[node.first + 1].boundsMax, closest, rightEntry);
+			unsigned int nearChild = leftEntry <= rightEntry ? node.first : node.first + 1;
+			unsigned int farChild = nearChild == node.first ? node.first + 1 : node.first;
+			if (leftHit && rightHit)
+			{
+				stack.push_back(farChild);
+				stack.push_back(nearChild);
+			}
+			else if (leftHit || rightHit)
+				stack.push_back(leftHit ? node.first : node.first + 1);
+			continue;
+		}
+		for (unsigned int i = node.first; i < node.first + node.count; i++)
+		{
+			const Item& item = items[order[i]];
+			if (!rayBox(origin, inverseDirection, item.boundsMin, item.boundsMax, closest, entry))
+				continue;
+			const Mesh& mesh = objects[item.object].model->meshes[item.mesh];
+			if (mesh.indices.empty())
+				continue;
+			// The ray in the mesh's space; the direction is not renormalized, so distances stay world distances
+			glm::mat4 inverseTransform = glm::inverse(objects[item.object].transform);
+			glm::vec3 localOrigin = glm::vec3(inverseTransform * glm::vec4(origin, 1.0f));
+			glm::vec3 localDirection = glm::vec3(inverseTransform * glm::vec4(direction, 0.0f));
+			unsigned int triangle = ~0u;
+			if (mesh.meshlets.empty())
+				intersectTriangles(mesh, 0, (unsigned int)mesh.indices.size(), localOrigin, localDirection, closest, triangle, trianglesTested);
+			else
+			{
+				// Only the meshlets whose bounding sphere the ray passes through
+				float directionLength2 = glm::dot(localDirection, localDirection);
+				for (unsigned int m = 0; m < mesh.meshlets.size(); m++)
+				{
+					const Meshlet& meshlet = mesh.meshlets[m];
+					glm::vec3 toCenter = meshlet.center - localOrigin;
+					float along = glm::dot(toCenter, localDirection) / directionLength2;
+					glm::vec3 nearest = toCenter - localDirection * std::max(along, 0.0f);
+					if (glm::dot(nearest, nearest) > meshlet.radius * meshlet.radius)
+						continue;
+					intersectTriangles(mesh, meshlet.firstIndex, meshlet.indexCount, localOrigin, localDirection, closest, triangle, trianglesTested);
+				}
+			}
+			if (triangle == ~0u)
+				continue;
+			hit = true;
+			result.object = item.object;
+			result.mesh = item.mesh;
+			result.triangle = triangle;
+			result.distance = closest;
+		}
+	}
+	if (hit)
+		result.position = origin + direction * result.distance;
+	return hit;
+}
@@ -0,0 +1,73 @@
+#pragma once
+// Std. Includes
+#include <vector>
+
+// GL Includes
+#include <glm/glm.hpp>
+
+#include "SceneObject.h"
+
+// Closest hit of SceneBVH::pick
+struct PickResult {
+    unsigned int object;
+    unsigned int mesh;
+    // First index of the triangle in the mesh's indices is 3 * triangle
+    unsigned int triangle;
+    // Along the ray as given, origin + distance * direction is the hit point
+    float distance;
+    glm::vec3 position;
+};
+
+// Bounding volume hierarchy over the meshes of all scene objects, one leaf item per mesh with its
+// world AABB. build() splits with the surface area heuristic over binned centroids; refit() only
+// updates the items of dynamic objects and walks up from them, so moving furniture keeps the tree
+// (call build() again when objects are added or removed). Frustum queries and ray picks descend it
+// in logarithmic time; picks then test the triangles of the meshes they reach, four at a time with
+// SSE, which needs the meshes' CPU side vertices/indices (ImportOptions::keepGeometry).
+class SceneBVH {
+    public:
+        SceneBVH();
+
+        void build(const std::vector<SceneObject>& objects);
+        void refit(const std::vector<SceneObject>& objects);
+
+        // Appends (object, mesh) of every item whose AABB touches the frustum; planes as from
+        // Camera::GetFrustumPlanes
+        void queryFrustum(const glm::vec4 planes[6], std::vector<std::pair<unsigned int, unsigned int> >& items) const;
+        // Closest triangle along the ray, false when nothing is hit
+        bool pick(const std::vector<SceneObject>& objects, const glm::vec3& origin, const glm::vec3& direction, PickResult& result) const;
+
+        unsigned int nodeCount() const { return (unsigned int)nodes.size(); }
+
+        // Statistics of the last query or pick
+        mutable unsigned int nodesVisited;
+        mutable unsigned int trianglesTested;
+
+    private:
+        struct Item {
+            unsigned int object;
+            unsigned int mesh;
+            glm::vec3 boundsMin;
+            glm::vec3 boundsMax;
+        };
+        // Inner nodes have count 0 and their children at first and first + 1, leaves hold
+        // order[first, first + count)
+        struct Node {
+            glm::vec3 boundsMin;
+            unsigned int first;
+            glm::vec3 boundsMax;
+            unsigned int count;
+        };
+
+        void split(unsigned int node, unsigned int depth);
+        void updateNode(unsigned int node);
+        void itemBounds(const SceneObject& object, Item& item) const;
+
+        std::vector<Item> items;
+        // Items in leaf order
+        std::vector<unsigned int> order;
+        std::vector<Node> nodes;
+        std::vector<unsigned int> parents;
+        // Leaf of every item, where refit starts walking up
+        std::vector<unsigned int> itemLeaves;
+};
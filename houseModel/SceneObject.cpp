@@ -0,0 +1,129 @@
+#include "SceneObject.h"
+// Std. Includes
+#include <cfloat>
+#include <cmath>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define SCENE_OBJECT_SSE
+#include <xmmintrin.h>
+#endif
+
+// Relative tolerance of the uniform scale test, on squared column lengths and dot products
+static const float uniformScaleTolerance = 1e-4f;
+
+SceneObject::SceneObject(Model* model, const glm::mat4& transform, bool meshletCulling)
+	: model(model), transform(transform), normalMatrix(computeNormalMatrix(transform)), meshletCulling(meshletCulling), dynamic(false)
+{
+	updateBounds();
+}
+
+void SceneObject::updateBounds()
+{
+	glm::vec3 localMin, localMax;
+	model->bounds(localMin, localMax);
+	transformBounds(transform, localMin, localMax, boundsMin, boundsMax);
+}
+
+void transformBounds(const glm::mat4& transform, const glm::vec3& localMin, const glm::vec3& localMax, glm::vec3& worldMin, glm::vec3& worldMax)
+{
+	worldMin = glm::vec3(FLT_MAX);
+	worldMax = glm::vec3(-FLT_MAX);
+	for (unsigned int corner = 0; corner < 8; corner++)
+	{
+		glm::vec3 point((corner & 1) ? localMax.x : localMin.x, (corner & 2) ? localMax.y : localMin.y, (corner & 4) ? localMax.z : localMin.z);
+		glm::vec3 world = glm::vec3(transform * glm::vec4(point, 1.0f));
+		worldMin = glm::min(worldMin, world);
+		worldMax = glm::max(worldMax, world);
+	}
+}
+
+glm::mat3 computeNormalMatrix(const glm::mat4& transform)
+{
+	glm::mat3 upper(transform);
+	float length0 = glm::dot(upper[0], upper[0]);
+	float tolerance = length0 * uniformScaleTolerance;
+	if (std::fabs(glm::dot(upper[1], upper[1]) - length0) <= tolerance && std::fabs(glm::dot(upper[2], upper[2]) - length0) <= tolerance
+		&& std::fabs(glm::dot(upper[0], upper[1])) <= tolerance && std::fabs(glm::dot(upper[1], upper[2])) <= tolerance
+		&& std::fabs(glm::dot(upper[0], upper[2])) <= tolerance)
+		return upper;
+	return glm::transpose(glm::inverse(upper));
+}
+
+#ifdef SCENE_OBJECT_SSE
+// Vector ops on columns stored as three __m128 (x, y, z), one matrix per lane
+static inline __m128 dot3(const __m128* a, const __m128* b)
+{
+	return _mm_add_ps(_mm_add_ps(_mm_mul_ps(a[0], b[0]), _mm_mul_ps(a[1], b[1])), _mm_mul_ps(a[2], b[2]));
+}
+
+static inline void cross3(const __m128* a, const __m128* b, __m128* result)
+{
+	result[0] = _mm_sub_ps(_mm_mul_ps(a[1], b[2]), _mm_mul_ps(a[2], b[1]));
+	result[1] = _mm_sub_ps(_mm_mul_ps(a[2], b[0]), _mm_mul_ps(a[0], b[2]));
+	result[2] = _mm_sub_ps(_mm_mul_ps(a[0], b[1]), _mm_mul_ps(a[1], b[0]));
+}
+
+static inline __m128 withinTolerance(__m128 value, __m128 tolerance)
+{
+	return _mm_cmple_ps(_mm_andnot_ps(_mm_set1_ps(-0.0f), value), tolerance);
+}
+#endif
+
+void updateNormalMatrices(std::vector<SceneObject>& objects)
+{
+	unsigned int i = 0;
+#ifdef SCENE_OBJECT_SSE
+	for (; i + 4 <= objects.size(); i += 4)
+	{
+		// Upper 3x3 of four transforms, element [column * 3 + row] of every object in its own lane
+		__m128 m[9];
+		for (int element = 0; element < 9; element++)
+		{
+			int column = element / 3, row = element % 3;
+			m[element] = _mm_setr_ps(objects[i].transform[column][row], objects[i + 1].transform[column][row],
+				objects[i + 2].transform[column][row], objects[i + 3].transform[column][row]);
+		}
+		// The inverse transpose has the columns c1 x c2, c2 x c0, c0 x c1 over the determinant
+		__m128 cofactors[9];
+		cross3(m + 3, m + 6, cofactors);
+		cross3(m + 6, m, cofactors + 3);
+		cross3(m, m + 3, cofactors + 6);
+		__m128 inverseDeterminant = _mm_div_ps(_mm_set1_ps(1.0f), dot3(m, cofactors));
+		// Lanes whose columns are orthogonal and equally long keep the upper 3x3
+		__m128 length0 = dot3(m, m);
+		__m128 tolerance = _mm_mul_ps(length0, _mm_set1_ps(uniformScaleTolerance));
+		__m128 uniform = withinTolerance(_mm_sub_ps(dot3(m + 3, m + 3), length0), tolerance);
+		uniform = _mm_and_ps(uniform, withinTolerance(_mm_sub_ps(dot3(m + 6, m + 6), length0), tolerance));
+		uniform = _mm_and_ps(uniform, withinTolerance(dot3(m, m + 3), tolerance));
+		uniform = _mm_and_ps(uniform, withinTolerance(dot3(m + 3, m + 6), tolerance));
+		uniform = _mm_and_ps(uniform, withinTolerance(dot3(m, m + 6), tolerance));
+		for (int element = 0; element < 9; element++)
+		{
+			__m128 general = _mm_mul_ps(cofactors[element], inverseDeterminant);
+			float lanes[4];
+			_mm_storeu_ps(lanes, _mm_or_ps(_mm_and_ps(uniform, m[element]), _mm_andnot_ps(uniform, general)));
+			for (int lane = 0; lane < 4; lane++)
+				objects[i + lane].normalMatrix[element / 3][element % 3] = lanes[lane];
+		}
+	}
+#endif
+	for (; i < objects.size(); i++)
+		objects[i].normalMatrix = computeNormalMatrix(objects[i].transform);
+}
+
+size_t staticCasterSignature(const std::vector<SceneObject>& objects)
+{
+	// FNV-1a over the model pointers and matrices
+	size_t hash = (size_t)14695981039346656037ULL;
+	for (unsigned int i = 0; i < objects.size(); i++)
+	{
+		if (objects[i].dynamic)
+			continue;
+		const unsigned char* bytes[2] = { (const unsigned char*)&objects[i].model, (const unsigned char*)&objects[i].transform };
+		size_t sizes[2] = { sizeof(objects[i].model), sizeof(objects[i].transform) };
+		for (unsigned int part = 0; part < 2; part++)
+			for (size_t byte = 0; byte < sizes[part]; byte++)
+				hash = (hash ^ bytes[part][byte]) * (size_t)1099511628211ULL;
+	}
+	return hash;
+}
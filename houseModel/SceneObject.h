@@ -0,0 +1,42 @@
+#pragma once
+// Std. Includes
+#include <vector>
+#include <cstddef>
+
+// GL Includes
+#include <glm/glm.hpp>
+
+#include "Model.h"
+
+// A model placed in the house. Only dynamic objects may change their transform after construction
+// (and have to call updateBounds() when they do).
+struct SceneObject {
+    Model* model;
+    glm::mat4 transform;
+    // computeNormalMatrix(transform), kept current for all objects by updateNormalMatrices
+    glm::mat3 normalMatrix;
+    // World space AABB of the model under transform
+    glm::vec3 boundsMin;
+    glm::vec3 boundsMax;
+    // Draw through a MeshletCuller for the camera, the model has to be built with meshlets
+    bool meshletCulling;
+    // Moves every frame, so its shadow is not cached with the static casters
+    bool dynamic;
+
+    SceneObject(Model* model, const glm::mat4& transform, bool meshletCulling = false);
+    void updateBounds();
+};
+
+// World AABB of a local box under transform
+void transformBounds(const glm::mat4& transform, const glm::vec3& localMin, const glm::vec3& localMax, glm::vec3& worldMin, glm::vec3& worldMax);
+
+// Matrix that takes normals through transform: the upper 3x3 itself when it only rotates and scales
+// uniformly (the shaders normalize after it), its inverse transpose otherwise
+glm::mat3 computeNormalMatrix(const glm::mat4& transform);
+// computeNormalMatrix for every object, four at a time with SSE; once per frame instead of an
+// inverse() per vertex in VertexShader.vs
+void updateNormalMatrices(std::vector<SceneObject>& objects);
+
+// Hash of the model and transform of every static object, it changes whenever one is moved, added or
+// removed; the shadow cache redraws static casters on a change (see CascadedShadowMap)
+size_t staticCasterSignature(const std::vector<SceneObject>& objects);
@@ -9,22 +9,28 @@
 
 #include <GL/glew.h>
 
+#include "UniformTable.h"
+#include "UniformBlocks.h"
+
 class Shader
 {
 public:
     GLuint Program;
+    // Locations of the program's active uniforms, reflected once after linking
+    UniformTable uniforms;
     enum Slot
     {
         DIFFUSE,
         SPECULAR
     };
 
-    // Constructor generates the shader on the fly
-    Shader(const GLchar* vertexPath, const GLchar* fragmentPath)
+    // Constructor generates the shader on the fly, the geometry stage is optional
+    Shader(const GLchar* vertexPath, const GLchar* fragmentPath, const GLchar* geometryPath = NULL)
     {
         // 1. Retrieve the vertex/fragment source code from filePath
         std::string vertexCode;
         std::string fragmentCode;
+        std::string geometryCode;
         std::ifstream vShaderFile;
         std::ifstream fShaderFile;
         // ensures ifstream objects can throw exceptions:
@@ -43,8 +49,18 @@ public:
             vShaderFile.close();
             fShaderFile.close();
             // Convert stream into string
-            vertexCode = vShaderStream.str();
-            fragmentCode = fShaderStream.str();
+            vertexCode = expandIncludes(vShaderStream.str(), vertexPath);
+            fragmentCode = expandIncludes(fShaderStream.str(), fragmentPath);
+            if (geometryPath)
+            {
+                std::ifstream gShaderFile;
+                gShaderFile.exceptions(std::ifstream::badbit);
+                gShaderFile.open(geometryPath);
+                std::stringstream gShaderStream;
+                gShaderStream << gShaderFile.rdbuf();
+                gShaderFile.close();
+                geometryCode = expandIncludes(gShaderStream.str(), geometryPath);
+            }
         }
         catch (std::ifstream::failure e)
         {
@@ -78,10 +94,27 @@ public:
             glGetShaderInfoLog(fragment, 512, NULL, infoLog);
             std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
         }
+        // Geometry Shader
+        GLuint geometry = 0;
+        if (geometryPath)
+        {
+            const GLchar* gShaderCode = geometryCode.c_str();
+            geometry = glCreateShader(GL_GEOMETRY_SHADER);
+            glShaderSource(geometry, 1, &gShaderCode, NULL);
+            glCompileShader(geometry);
+            glGetShaderiv(geometry, GL_COMPILE_STATUS, &success);
+            if (!success)
+            {
+                glGetShaderInfoLog(geometry, 512, NULL, infoLog);
+                std::cout << "ERROR::SHADER::GEOMETRY::COMPILATION_FAILED\n" << infoLog << std::endl;
+            }
+        }
         // Shader Program
         this->Program = glCreateProgram();
         glAttachShader(this->Program, vertex);
         glAttachShader(this->Program, fragment);
+        if (geometry)
+            glAttachShader(this->Program, geometry);
         glLinkProgram(this->Program);
         // Print linking errors if any
         glGetProgramiv(this->Program, GL_LINK_STATUS, &success);
@@ -90,16 +123,80 @@ public:
             glGetProgramInfoLog(this->Program, 512, NULL, infoLog);
             std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
         }
+        this->uniforms.reflect(this->Program);
+        bindUniformBlocks(this->Program);
         // Delete the shaders as they're linked into our program now and no longer necessery
         glDeleteShader(vertex);
         glDeleteShader(fragment);
+        if (geometry)
+            glDeleteShader(geometry);
 
     }
+    // Replaces every #include "file" line with that file's source, found next to the including file
+    static std::string expandIncludes(const std::string& source, const std::string& path)
+    {
+        std::string directory = path.substr(0, path.find_last_of("\\/") + 1);
+        std::stringstream sourceStream(source), expanded;
+        std::string line;
+        while (std::getline(sourceStream, line))
+        {
+            size_t start = line.find_first_not_of(" \t");
+            if (start == std::string::npos || line.compare(start, 10, "#include \"") != 0)
+            {
+                expanded << line << "\n";
+                continue;
+            }
+            size_t end = line.find('"', start + 10);
+            std::string includePath = directory + line.substr(start + 10, end - start - 10);
+            std::ifstream includeFile(includePath.c_str());
+            if (!includeFile)
+            {
+                std::cout << "ERROR::SHADER::INCLUDE_NOT_FOUND " << includePath << std::endl;
+                continue;
+            }
+            std::stringstream includeStream;
+            includeStream << includeFile.rdbuf();
+            expanded << expandIncludes(includeStream.str(), includePath) << "\n";
+        }
+        return expanded.str();
+    }
     // Uses the current shader
     void Use()
     {
         glUseProgram(this->Program);
     }
+
+    // Typed handle of a uniform, for loops that set it over and over
+    template <typename T>
+    Uniform<T> uniform(const std::string& name) const
+    {
+        return this->uniforms.get<T>(name);
+    }
+    // Setters skip the upload when the value didn't change since the last one, the program has to be in use
+    void setInt(const std::string& name, int value) const
+    {
+        this->uniforms.get<int>(name).set(value);
+    }
+    void setFloat(const std::string& name, float value) const
+    {
+        this->uniforms.get<float>(name).set(value);
+    }
+    void setVec3(const std::string& name, const glm::vec3& value) const
+    {
+        this->uniforms.get<glm::vec3>(name).set(value);
+    }
+    void setVec4(const std::string& name, const glm::vec4& value) const
+    {
+        this->uniforms.get<glm::vec4>(name).set(value);
+    }
+    void setMat3(const std::string& name, const glm::mat3& value) const
+    {
+        this->uniforms.get<glm::mat3>(name).set(value);
+    }
+    void setMat4(const std::string& name, const glm::mat4& value) const
+    {
+        this->uniforms.get<glm::mat4>(name).set(value);
+    }
 };
 
 #endif
@@ -0,0 +1,57 @@
+#include "ShadowAtlas.h"
+
+ShadowAtlas::ShadowAtlas(unsigned int size, unsigned int minTile)
+	: texelsAllocated(0), tilesAllocated(0), atlasSize(size)
+{
+	unsigned int levels = 1;
+	for (unsigned int tile = size; tile / 2 >= minTile; tile /= 2)
+		levels++;
+	freeNodes.resize(levels);
+	clear();
+}
+
+void ShadowAtlas::clear()
+{
+	for (unsigned int level = 0; level < freeNodes.size(); level++)
+		freeNodes[level].clear();
+	ShadowTile root = { 0, 0, atlasSize };
+	freeNodes[0].push_back(root);
+	texelsAllocated = 0;
+	tilesAllocated = 0;
+}
+
+bool ShadowAtlas::allocate(unsigned int size, ShadowTile& tile)
+{
+	// Deepest level whose nodes still hold size
+	unsigned int level = 0;
+	unsigned int levelSize = atlasSize;
+	while (level + 1 < freeNodes.size() && levelSize / 2 >= size)
+	{
+		levelSize /= 2;
+		level++;
+	}
+	// Nearest level up with a free node
+	int source = (int)level;
+	while (source >= 0 && freeNodes[source].empty())
+		source--;
+	if (source < 0)
+		return false;
+	ShadowTile node = freeNodes[source].back();
+	freeNodes[source].pop_back();
+	// Split down to the requested level, keeping the first quadrant and freeing the other three
+	for (unsigned int split = (unsigned int)source; split < level; split++)
+	{
+		unsigned int half = node.size / 2;
+		ShadowTile right = { node.x + half, node.y, half };
+		ShadowTile top = { node.x, node.y + half, half };
+		ShadowTile corner = { node.x + half, node.y + half, half };
+		freeNodes[split + 1].push_back(corner);
+		freeNodes[split + 1].push_back(top);
+		freeNodes[split + 1].push_back(right);
+		node.size = half;
+	}
+	tile = node;
+	texelsAllocated += (unsigned long long)node.size * node.size;
+	tilesAllocated++;
+	return true;
+}
@@ -0,0 +1,34 @@
+#pragma once
+// Std. Includes
+#include <vector>
+
+// Square tile of a ShadowAtlas, in texels
+struct ShadowTile {
+    unsigned int x, y, size;
+};
+
+// Quadtree allocator of power of two tiles in a square shadow atlas. Every level of the tree keeps a
+// list of its free nodes; a request takes a free node of its level or splits the smallest larger one
+// into four. Meant to be cleared and refilled every frame with the largest tiles first, which never
+// leaves a hole, so freeTexels() alone tells whether a request fits.
+class ShadowAtlas {
+    public:
+        ShadowAtlas(unsigned int size, unsigned int minTile);
+
+        // Frees every tile
+        void clear();
+        // Rounds size up to a power of two in [minTile, size()], false when no node of that size is free
+        bool allocate(unsigned int size, ShadowTile& tile);
+
+        unsigned int size() const { return atlasSize; }
+        unsigned long long freeTexels() const { return (unsigned long long)atlasSize * atlasSize - texelsAllocated; }
+
+        // Statistics, since the last clear()
+        unsigned long long texelsAllocated;
+        unsigned int tilesAllocated;
+
+    private:
+        unsigned int atlasSize;
+        // Free nodes per level, level 0 is the whole atlas
+        std::vector<std::vector<ShadowTile> > freeNodes;
+};
@@ -0,0 +1,233 @@
+#include "TextureLoader.h"
+// Std. Includes
+#include <string>
+#include <iostream>
+#include <cstring>
+#include "stb_image.h"
+
+TextureLoader& TextureLoader::instance()
+{
+	static TextureLoader loader;
+	return loader;
+}
+
+TextureLoader::TextureLoader() : frameByteBudget(8 << 20), stopping(false), pending(0), nextSerial(0), nextPixelBuffer(0), pixelBuffersCreated(false)
+{
+	// Leave a core for the render thread
+	unsigned int workerCount = std::thread::hardware_concurrency();
+	workerCount = workerCount > 1 ? workerCount - 1 : 1;
+	if (workerCount > 4)
+		workerCount = 4;
+	for (unsigned int i = 0; i < workerCount; i++)
+		workers.push_back(std::thread(&TextureLoader::workerLoop, this));
+}
+
+TextureLoader::~TextureLoader()
+{
+	{
+		std::lock_guard<std::mutex> lock(decodeMutex);
+		stopping = true;
+	}
+	decodeReady.notify_all();
+	for (unsigned int i = 0; i < workers.size(); i++)
+		workers[i].join();
+	// The GL context is gone by now, its pixel buffers were deleted by shutdown()
+	for (unsigned int i = 0; i < uploadQueue.size(); i++)
+		stbi_image_free(uploadQueue[i].pixels);
+}
+
+unsigned int TextureLoader::load(const std::string& path, bool clampAlphaEdges)
+{
+	unsigned int textureID;
+	glGenTextures(1, &textureID);
+
+	// Placeholder so the id can be sampled before the real image arrives
+	static const unsigned char placeholder[4] = { 128, 128, 128, 255 };
+	glBindTexture(GL_TEXTURE_2D, textureID);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, placeholder);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	Job job;
+	job.textureID = textureID;
+	job.serial = nextSerial++;
+	job.path = path;
+	job.clampAlphaEdges = clampAlphaEdges;
+	job.pixels = 0;
+	job.width = job.height = job.components = 0;
+	{
+		std::lock_guard<std::mutex> lock(decodeMutex);
+		decodeQueue.push_back(job);
+	}
+	decodeReady.notify_one();
+	pending++;
+	inFlight[textureID] = job.serial;
+	return textureID;
+}
+
+void TextureLoader::cancel(unsigned int textureID)
+{
+	std::map<unsigned int, unsigned int>::iterator job = inFlight.find(textureID);
+	if (job == inFlight.end())
+		return;
+	unsigned int serial = job->second;
+	inFlight.erase(job);
+	{
+		std::lock_guard<std::mutex> lock(decodeMutex);
+		for (std::deque<Job>::iterator queued = decodeQueue.begin(); queued != decodeQueue.end(); ++queued)
+		{
+			if (queued->serial == serial)
+			{
+				// Not decoded yet, nothing else to undo
+				decodeQueue.erase(queued);
+				pending--;
+				return;
+			}
+		}
+	}
+	cancelled.insert(serial);
+}
+
+void TextureLoader::shutdown()
+{
+	if (pixelBuffersCreated)
+	{
+		glDeleteBuffers(PIXEL_BUFFER_COUNT, pixelBuffers);
+		pixelBuffersCreated = false;
+		nextPixelBuffer = 0;
+	}
+}
+
+void TextureLoader::workerLoop()
+{
+	for (;;)
+	{
+		Job job;
+		{
+			std::unique_lock<std::mutex> lock(decodeMutex);
+			while (!stopping && decodeQueue.empty())
+				decodeReady.wait(lock);
+			if (stopping)
+				return;
+			job = decodeQueue.front();
+			decodeQueue.pop_front();
+		}
+		job.pixels = stbi_load(job.path.c_str(), &job.width, &job.height, &job.components, 0);
+		{
+			std::lock_guard<std::mutex> lock(uploadMutex);
+			uploadQueue.push_back(job);
+		}
+		uploadReady.notify_one();
+	}
+}
+
+void TextureLoader::update()
+{
+	uploadDecoded(frameByteBudget, false);
+}
+
+void TextureLoader::finish()
+{
+	while (pending > 0)
+		uploadDecoded((size_t)-1, true);
+}
+
+void TextureLoader::uploadDecoded(size_t byteBudget, bool wait)
+{
+	size_t uploaded = 0;
+	bool first = true;
+	for (;;)
+	{
+		Job job;
+		{
+			std::unique_lock<std::mutex> lock(uploadMutex);
+			if (wait && first)
+			{
+				while (uploadQueue.empty())
+					uploadReady.wait(lock);
+			}
+			if (uploadQueue.empty())
+				return;
+			size_t bytes = (size_t)uploadQueue.front().width * uploadQueue.front().height * uploadQueue.front().components;
+			// Always make progress, even on an image bigger than the whole budget
+			if (!first && uploaded + bytes > byteBudget)
+				return;
+			job = uploadQueue.front();
+			uploadQueue.pop_front();
+			uploaded += bytes;
+		}
+		first = false;
+		std::set<unsigned int>::iterator dropped = cancelled.find(job.serial);
+		if (dropped != cancelled.end())
+		{
+			cancelled.erase(dropped);
+			stbi_image_free(job.pixels);
+		}
+		else
+		{
+			inFlight.erase(job.textureID);
+			upload(job);
+		}
+		pending--;
+	}
+}
+
+void TextureLoader::upload(Job& job)
+{
+	if (!job.pixels)
+	{
+		std::cout << "Texture failed to load at path: " << job.path << std::endl;
+		return;
+	}
+	if (!pixelBuffersCreated)
+	{
+		glGenBuffers(PIXEL_BUFFER_COUNT, pixelBuffers);
+		pixelBuffersCreated = true;
+	}
+
+	GLenum format;
+	if (job.components == 1)
+		format = GL_RED;
+	else if (job.components == 2)
+		format = GL_RG;
+	else if (job.components == 3)
+		format = GL_RGB;
+	else
+		format = GL_RGBA;
+	size_t size = (size_t)job.width * job.height * job.components;
+
+	// Orphaning the buffer lets the driver hand out fresh storage while the previous upload from it is still in flight
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffers[nextPixelBuffer]);
+	nextPixelBuffer = (nextPixelBuffer + 1) % PIXEL_BUFFER_COUNT;
+	glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW);
+	void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+	const void* source = 0; // offset into the bound pixel buffer
+	if (mapped)
+	{
+		std::memcpy(mapped, job.pixels, size);
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+	}
+	else
+	{
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		source = job.pixels;
+	}
+
+	// stb_image rows are tightly packed
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glBindTexture(GL_TEXTURE_2D, job.textureID);
+	glTexImage2D(GL_TEXTURE_2D, 0, format, job.width, job.height, 0, format, GL_UNSIGNED_BYTE, source);
+	glGenerateMipmap(GL_TEXTURE_2D);
+
+	GLint wrap = job.clampAlphaEdges && format == GL_RGBA ? GL_CLAMP_TO_EDGE : GL_REPEAT;
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrap);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	stbi_image_free(job.pixels);
+}
@@ -0,0 +1,82 @@
+#pragma once
+// Std. Includes
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <set>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+// GL Includes
+#include <GL/glew.h>
+
+// Number of pixel unpack buffers uploads rotate through
+const unsigned int PIXEL_BUFFER_COUNT = 4;
+
+// Loads image textures without stalling the render thread. Images are decoded by stb_image on
+// background threads; update() then streams them to the GPU through a ring of pixel buffer objects,
+// at most frameByteBudget bytes per frame. Texture ids are handed out immediately and show a 1x1
+// placeholder until their image is resident.
+class TextureLoader {
+    public:
+        static TextureLoader& instance();
+
+        // Returns the texture id right away, the image is decoded in the background.
+        // clampAlphaEdges: use GL_CLAMP_TO_EDGE for RGBA images (avoids semi-transparent borders)
+        unsigned int load(const std::string& path, bool clampAlphaEdges = false);
+        // Call once per frame on the context thread, uploads decoded images until the budget is used up
+        void update();
+        // Blocks until every requested texture is resident
+        void finish();
+        // Drops the image still on its way to textureID, for textures deleted before their upload
+        // (see TextureRegistry::release), so it never lands in a reused texture name
+        void cancel(unsigned int textureID);
+        // Deletes the pixel buffers, call on the context thread before it is destroyed
+        void shutdown();
+        // Textures requested but not uploaded yet
+        unsigned int pendingCount() const { return pending; }
+
+        // Bytes of pixel data update() may upload per frame, at least one image is always uploaded
+        size_t frameByteBudget;
+
+    private:
+        struct Job {
+            unsigned int textureID;
+            // Tells jobs apart when a deleted texture's id is handed out again
+            unsigned int serial;
+            std::string path;
+            bool clampAlphaEdges;
+            unsigned char* pixels;
+            int width, height, components;
+        };
+
+        TextureLoader();
+        ~TextureLoader();
+        TextureLoader(const TextureLoader&);
+        TextureLoader& operator=(const TextureLoader&);
+
+        void workerLoop();
+        void uploadDecoded(size_t byteBudget, bool wait);
+        void upload(Job& job);
+
+        std::vector<std::thread> workers;
+        std::deque<Job> decodeQueue;
+        std::deque<Job> uploadQueue;
+        std::mutex decodeMutex;
+        std::mutex uploadMutex;
+        std::condition_variable decodeReady;
+        std::condition_variable uploadReady;
+        bool stopping;
+        // Only touched on the context thread
+        unsigned int pending;
+        unsigned int nextSerial;
+        // texture id -> serial of its job until the upload
+        std::map<unsigned int, unsigned int> inFlight;
+        // Serials of cancelled jobs that were already decoding, uploadDecoded drops them
+        std::set<unsigned int> cancelled;
+        unsigned int pixelBuffers[PIXEL_BUFFER_COUNT];
+        unsigned int nextPixelBuffer;
+        bool pixelBuffersCreated;
+};
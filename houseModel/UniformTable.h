@@ -0,0 +1,155 @@
+#pragma once
+// Std. Includes
+#include <string>
+#include <vector>
+#include <cstring>
+#include <algorithm>
+#include <unordered_map>
+
+// GL Includes
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+class UniformTable;
+
+// Location of one uniform, looked up once and typed so set() issues the matching glUniform call.
+// Hot loops hold these instead of passing names. An unknown name gives location -1, which GL ignores.
+// Handles from a UniformTable skip the call when the value is the one already uploaded.
+template <typename T>
+struct Uniform {
+    GLint location;
+    const UniformTable* table;
+
+    Uniform() : location(-1), table(0) {}
+    explicit Uniform(GLint location, const UniformTable* table = 0) : location(location), table(table) {}
+    bool valid() const { return location != -1; }
+    // The table's program has to be in use
+    void set(const T& value) const;
+};
+
+inline void uploadUniform(GLint location, const bool& value) { glUniform1i(location, (int)value); }
+inline void uploadUniform(GLint location, const int& value) { glUniform1i(location, value); }
+inline void uploadUniform(GLint location, const float& value) { glUniform1f(location, value); }
+inline void uploadUniform(GLint location, const glm::vec2& value) { glUniform2fv(location, 1, &value[0]); }
+inline void uploadUniform(GLint location, const glm::vec3& value) { glUniform3fv(location, 1, &value[0]); }
+inline void uploadUniform(GLint location, const glm::vec4& value) { glUniform4fv(location, 1, &value[0]); }
+inline void uploadUniform(GLint location, const glm::mat2& value) { glUniformMatrix2fv(location, 1, GL_FALSE, &value[0][0]); }
+inline void uploadUniform(GLint location, const glm::mat3& value) { glUniformMatrix3fv(location, 1, GL_FALSE, &value[0][0]); }
+inline void uploadUniform(GLint location, const glm::mat4& value) { glUniformMatrix4fv(location, 1, GL_FALSE, &value[0][0]); }
+
+// Name -> location of every active uniform of a linked program, reflected once with
+// glGetActiveUniform so setters do a hash lookup instead of a glGetUniformLocation per call.
+// Arrays are registered under their base name and under every element ("lights", "lights[0]", ...),
+// uniforms inside blocks have no location and are left out.
+// The table also shadows the last value uploaded to every location, so re-setting an unchanged
+// value (static lights, the same view matrix for every object) never reaches the driver. Everything
+// that sets a uniform of the program has to go through the table for the shadow to stay right.
+class UniformTable {
+    public:
+        UniformTable() : uploadsIssued(0), uploadsSkipped(0) {}
+
+        void reflect(GLuint program)
+        {
+            locations.clear();
+            shadows.clear();
+            GLint count = 0, maxLength = 0;
+            glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+            glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+            std::vector<GLchar> buffer(maxLength > 0 ? maxLength : 1);
+            for (GLint i = 0; i < count; i++)
+            {
+                GLsizei length = 0;
+                GLint size = 0;
+                GLenum type = 0;
+                glGetActiveUniform(program, (GLuint)i, (GLsizei)buffer.size(), &length, &size, &type, buffer.data());
+                std::string name(buffer.data(), length);
+                GLint location = glGetUniformLocation(program, name.c_str());
+                if (location == -1)
+                    continue;
+                // Arrays are reported as "name[0]"
+                bool isArray = name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0;
+                if (!isArray)
+                {
+                    locations[name] = location;
+                    continue;
+                }
+                std::string base = name.substr(0, name.size() - 3);
+                locations[base] = location;
+                for (GLint element = 0; element < size; element++)
+                {
+                    std::string elementName = base + "[" + std::to_string(element) + "]";
+                    locations[elementName] = glGetUniformLocation(program, elementName.c_str());
+                }
+            }
+            GLint maxLocation = -1;
+            for (std::unordered_map<std::string, GLint>::const_iterator it = locations.begin(); it != locations.end(); ++it)
+                maxLocation = std::max(maxLocation, it->second);
+            shadows.resize(maxLocation + 1);
+        }
+
+        GLint location(const std::string& name) const
+        {
+            std::unordered_map<std::string, GLint>::const_iterator found = locations.find(name);
+            return found != locations.end() ? found->second : -1;
+        }
+
+        template <typename T>
+        Uniform<T> get(const std::string& name) const
+        {
+            return Uniform<T>(location(name), this);
+        }
+
+        unsigned int size() const { return (unsigned int)locations.size(); }
+
+        // Compares value against the shadow of location and records it, false means the upload can be skipped
+        bool changed(GLint location, const void* value, unsigned int bytes) const
+        {
+            if (location < 0 || (size_t)location >= shadows.size() || bytes > sizeof(Shadow::data))
+            {
+                uploadsIssued++;
+                return true;
+            }
+            Shadow& shadow = shadows[location];
+            if (shadow.valid && memcmp(shadow.data, value, bytes) == 0)
+            {
+                uploadsSkipped++;
+                return false;
+            }
+            memcpy(shadow.data, value, bytes);
+            shadow.valid = true;
+            uploadsIssued++;
+            return true;
+        }
+        // Forgets the shadowed values, for when something set the program's uniforms behind the table's back
+        void invalidate() const
+        {
+            for (size_t i = 0; i < shadows.size(); i++)
+                shadows[i].valid = false;
+        }
+
+        // Statistics, since the last resetCounters() (main sums and resets those of every program each frame)
+        mutable unsigned int uploadsIssued;
+        mutable unsigned int uploadsSkipped;
+        void resetCounters() { uploadsIssued = 0; uploadsSkipped = 0; }
+
+    private:
+        struct Shadow {
+            bool valid;
+            unsigned char data[sizeof(glm::mat4)];
+            Shadow() : valid(false) {}
+        };
+
+        std::unordered_map<std::string, GLint> locations;
+        // Indexed by location; a cache of GL state, so it may change through a const table
+        mutable std::vector<Shadow> shadows;
+};
+
+template <typename T>
+inline void Uniform<T>::set(const T& value) const
+{
+    if (location == -1)
+        return;
+    if (table && !table->changed(location, &value, sizeof(T)))
+        return;
+    uploadUniform(location, value);
+}
@@ -0,0 +1,197 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Shader.h"
+#include "Model.h"
+#include "MeshArena.h"
+#include "IndirectBatch.h"
+#include "UniformBlocks.h"
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+
+// Renders two placed copies of a small model through IndirectBatch, once with
+// glMultiDrawElementsIndirect and once with the per mesh fallback, and checks that both paths give
+// the same image with the copies where they belong. Needs no GPU, Mesa's llvmpipe has GL 4.3:
+//   LIBGL_ALWAYS_SOFTWARE=1 xvfb-run indirectBatchTest [shader directory]
+// Exits with 0 when every check passes.
+static const GLuint WIDTH = 256, HEIGHT = 256;
+
+// Two quads as separate objects so every instance is two commands; the upper one faces up and right,
+// its normals show whether the normal matrix reached the shader
+static const char* testModel =
+    "o lower\n"
+    "v -0.5 -0.5 0.0\nv 0.5 -0.5 0.0\nv 0.5 0.0 0.0\nv -0.5 0.0 0.0\n"
+    "vn 0.0 0.0 1.0\n"
+    "f 1//1 2//1 3//1\nf 1//1 3//1 4//1\n"
+    "o upper\n"
+    "v -0.5 0.0 0.0\nv 0.5 0.0 0.0\nv 0.5 0.5 0.0\nv -0.5 0.5 0.0\n"
+    "vn 0.48 0.36 0.8\n"
+    "f 5//2 6//2 7//2\nf 5//2 7//2 8//2\n";
+
+// Normals as colors, the same for both vertex shaders
+static const char* testFragmentShader =
+    "#version 330 core\n"
+    "in vec3 Normal;\n"
+    "out vec4 color;\n"
+    "void main()\n"
+    "{\n"
+    "    color = vec4(normalize(Normal) * 0.5f + 0.5f, 1.0f);\n"
+    "}\n";
+
+static bool writeFile(const char* path, const char* text)
+{
+    std::ofstream file(path);
+    file << text;
+    return file.good();
+}
+
+static void render(IndirectBatch& batch, Shader& shader, std::vector<unsigned char>& pixels)
+{
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    shader.Use();
+    batch.draw(&shader);
+    pixels.resize(WIDTH * HEIGHT * 4);
+    glReadPixels(0, 0, WIDTH, HEIGHT, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+}
+
+// Alpha is 1 wherever a quad was drawn
+static bool covered(const std::vector<unsigned char>& pixels, const glm::ivec2& pixel)
+{
+    return pixels[(pixel.y * WIDTH + pixel.x) * 4 + 3] != 0;
+}
+
+static bool check(bool passed, const char* what)
+{
+    std::cout << (passed ? "ok   " : "FAIL ") << what << std::endl;
+    return passed;
+}
+
+int main(int argc, char** argv)
+{
+    std::string shaderDirectory = argc > 1 ? argv[1] : "./src/shaders/";
+
+    // glfw: hidden window, the batch is drawn into a framebuffer object
+    // ------------------------------
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    GLFWwindow* window = glfwCreateWindow(WIDTH, HEIGHT, "indirect batch test", NULL, NULL);
+    if (window == NULL)
+    {
+        std::cout << "Failed to create a GL 4.3 context" << std::endl;
+        glfwTerminate();
+        return 1;
+    }
+    glfwMakeContextCurrent(window);
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return 1;
+    }
+    if (!IndirectBatch::supported())
+    {
+        std::cout << "The context has no GL 4.3" << std::endl;
+        glfwTerminate();
+        return 1;
+    }
+    if (!writeFile("indirectBatchTest.obj", testModel) || !writeFile("indirectBatchTest.frag", testFragmentShader))
+    {
+        std::cout << "Failed to write the test model" << std::endl;
+        glfwTerminate();
+        return 1;
+    }
+
+    bool passed = true;
+    {
+        GLuint framebuffer, renderbuffers[2];
+        glGenFramebuffers(1, &framebuffer);
+        glGenRenderbuffers(2, renderbuffers);
+        glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[0]);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, WIDTH, HEIGHT);
+        glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[1]);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, WIDTH, HEIGHT);
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderbuffers[0]);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, renderbuffers[1]);
+        glViewport(0, 0, WIDTH, HEIGHT);
+        glEnable(GL_DEPTH_TEST);
+
+        Shader indirectShader((shaderDirectory + "indirectVertexShader.vs").c_str(), "indirectBatchTest.frag");
+        Shader fallbackShader((shaderDirectory + "VertexShader.vs").c_str(), "indirectBatchTest.frag");
+        glm::vec3 eye(0.0f, 0.0f, 4.0f);
+        glm::mat4 view = glm::lookAt(eye, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+        glm::mat4 projection = glm::perspective(glm::radians(45.0f), (GLfloat)WIDTH / (GLfloat)HEIGHT, 0.1f, 100.0f);
+        FrameUniforms frameUniforms;
+        frameUniforms.update(view, projection, eye);
+
+        // Compact vertices like the furniture of the house
+        MeshArena arena(VERTEX_FORMAT_COMPACT);
+        ImportOptions options;
+        options.arena = &arena;
+        Model model("indirectBatchTest.obj", false, options);
+        IndirectBatch batch(&arena);
+        // A uniformly scaled copy on the left, a non uniformly scaled and turned one on the right
+        glm::mat4 transforms[2] = {
+            glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(-0.8f, 0.0f, 0.0f)), glm::vec3(0.8f)),
+            glm::scale(glm::rotate(glm::translate(glm::mat4(1.0f), glm::vec3(0.8f, 0.0f, 0.0f)), glm::radians(30.0f), glm::vec3(0.0f, 1.0f, 0.0f)), glm::vec3(0.6f, 1.2f, 1.0f))
+        };
+        glm::ivec2 centers[2];
+        for (unsigned int i = 0; i < 2; i++)
+        {
+            batch.setTransform(batch.add(model), transforms[i]);
+            // Pixels just below and above the seam of the two quads
+            glm::vec4 clip = projection * view * transforms[i] * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+            centers[i] = glm::ivec2((clip.x / clip.w * 0.5f + 0.5f) * WIDTH, (clip.y / clip.w * 0.5f + 0.5f) * HEIGHT);
+        }
+        glm::ivec2 offsets[2] = { glm::ivec2(0, -8), glm::ivec2(0, 8) };
+
+        std::vector<unsigned char> indirectPixels, fallbackPixels;
+        render(batch, indirectShader, indirectPixels);
+        passed &= check(model.meshes.size() == 2 && batch.drawCount == 4 && batch.submitCalls == 1, "four commands in one multi draw");
+        for (unsigned int i = 0; i < 2; i++)
+            for (unsigned int o = 0; o < 2; o++)
+                passed &= check(covered(indirectPixels, centers[i] + offsets[o]), "indirect draw covers the copy");
+        passed &= check(!covered(indirectPixels, glm::ivec2(WIDTH / 2, HEIGHT / 2)), "nothing between the copies");
+
+        // The arena VAO is shared with Mesh::Draw, the per instance draw ID must not stay enabled
+        GLint enabled = 1, divisor = 1;
+        glBindVertexArray(arena.vertexArray());
+        glGetVertexAttribiv(3, GL_VERTEX_ATTRIB_ARRAY_ENABLED, &enabled);
+        glGetVertexAttribiv(3, GL_VERTEX_ATTRIB_ARRAY_DIVISOR, &divisor);
+        glBindVertexArray(0);
+        passed &= check(enabled == 0 && divisor == 0, "draw ID attribute reset after the multi draw");
+
+        batch.indirect = false;
+        render(batch, fallbackShader, fallbackPixels);
+        passed &= check(batch.drawCount == 4 && batch.submitCalls == 4, "fallback draws every command");
+        unsigned int differing = 0;
+        for (unsigned int i = 0; i < indirectPixels.size(); i++)
+            if (std::abs((int)indirectPixels[i] - (int)fallbackPixels[i]) > 2)
+                differing++;
+        passed &= check(differing == 0, "indirect and fallback images match");
+
+        // Hidden instances keep their commands with no instances
+        batch.indirect = true;
+        batch.setVisible(1, false);
+        render(batch, indirectShader, indirectPixels);
+        passed &= check(batch.drawCount == 2, "hidden copy leaves two draws");
+        passed &= check(covered(indirectPixels, centers[0] + offsets[0]) && !covered(indirectPixels, centers[1] + offsets[0]), "only the visible copy is drawn");
+
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glDeleteRenderbuffers(2, renderbuffers);
+        glDeleteFramebuffers(1, &framebuffer);
+    }
+    glfwTerminate();
+    std::cout << (passed ? "passed" : "failed") << std::endl;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,162 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Shader.h"
+#include "LightPoint.h"
+#include "LightBuffer.h"
+#include "LightClusters.h"
+#include "CascadedShadowMap.h"
+#include "PointShadowMaps.h"
+#include "UniformBlocks.h"
+
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include <vector>
+
+// Cost of point lighting against light count: CPU cluster build per frame, and GPU time of a
+// full screen floor lit brute force (every light per fragment) versus clustered.
+// usage: lightClusterBenchmark [frames], lamps are scattered over the house's floor plan
+static const GLuint WIDTH = 800, HEIGHT = 600;
+
+static float randomRange(float low, float high)
+{
+    return low + (high - low) * (float)rand() / (float)RAND_MAX;
+}
+
+// GPU milliseconds of drawing the floor, averaged over frames
+static double drawFloorMs(Shader& shader, GLuint floorVAO, GLuint query, int frames)
+{
+    double total = 0.0;
+    for (int frame = 0; frame < frames; frame++)
+    {
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        glBeginQuery(GL_TIME_ELAPSED, query);
+        glBindVertexArray(floorVAO);
+        glDrawArrays(GL_TRIANGLES, 0, 6);
+        glBindVertexArray(0);
+        glEndQuery(GL_TIME_ELAPSED);
+        GLuint64 nanoseconds = 0;
+        glGetQueryObjectui64v(query, GL_QUERY_RESULT, &nanoseconds);
+        total += nanoseconds / 1.0e6;
+    }
+    return total / frames;
+}
+
+int main(int argc, char** argv)
+{
+    int frames = argc > 1 ? atoi(argv[1]) : 100;
+    if (frames < 1)
+        frames = 1;
+
+    // glfw: hidden window, the floor is drawn into its default framebuffer
+    // ------------------------------
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    GLFWwindow* window = glfwCreateWindow(WIDTH, HEIGHT, "light cluster benchmark", NULL, NULL);
+    if (window == NULL)
+    {
+        std::cout << "Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return -1;
+    }
+    glViewport(0, 0, WIDTH, HEIGHT);
+    glEnable(GL_DEPTH_TEST);
+
+    // The lights, clusters and shader free their GL objects at the end of this scope, before glfwTerminate
+    {
+        Shader shader(".\\src\\shaders\\VertexShader.vs", ".\\src\\shaders\\FragmentShader.frag");
+        // Floor of the house, looked at from above so it fills the screen
+        GLfloat floorVertices[] = {
+            // Positions          // Normals         // Texture Coords
+            -5.0f, 0.0f, -5.0f,   0.0f, 1.0f, 0.0f,  0.0f, 0.0f,
+            -5.0f, 0.0f,  5.0f,   0.0f, 1.0f, 0.0f,  0.0f, 1.0f,
+             5.0f, 0.0f,  5.0f,   0.0f, 1.0f, 0.0f,  1.0f, 1.0f,
+            -5.0f, 0.0f, -5.0f,   0.0f, 1.0f, 0.0f,  0.0f, 0.0f,
+             5.0f, 0.0f,  5.0f,   0.0f, 1.0f, 0.0f,  1.0f, 1.0f,
+             5.0f, 0.0f, -5.0f,   0.0f, 1.0f, 0.0f,  1.0f, 0.0f
+        };
+        GLuint floorVAO, floorVBO;
+        glGenVertexArrays(1, &floorVAO);
+        glGenBuffers(1, &floorVBO);
+        glBindVertexArray(floorVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, floorVBO);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(floorVertices), floorVertices, GL_STATIC_DRAW);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (GLvoid*)0);
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (GLvoid*)(3 * sizeof(GLfloat)));
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (GLvoid*)(6 * sizeof(GLfloat)));
+        glBindVertexArray(0);
+        GLuint query;
+        glGenQueries(1, &query);
+
+        glm::vec3 eye(0.0f, 4.0f, 3.0f);
+        glm::mat4 view = glm::lookAt(eye, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+        glm::mat4 projection = glm::perspective(glm::radians(45.0f), (GLfloat)WIDTH / (GLfloat)HEIGHT, 0.1f, 100.0f);
+        FrameUniforms frameUniforms;
+        frameUniforms.update(view, projection, eye);
+        LightBuffer lightBuffer;
+        lightBuffer.setDirectional(LightDirectional(glm::vec3(0.2f, 1.0f, -0.3f), 0.05f, 0.1f, 0.1f));
+        LightClusters lightClusters;
+        lightClusters.setProjection(projection, 0.1f, 100.0f, WIDTH, HEIGHT);
+
+        shader.Use();
+        shader.setMat4("model", glm::mat4(1.0f));
+        shader.setMat3("normalMatrix", glm::mat3(1.0f));
+        shader.setInt("vertexFormat", 0);
+        shader.setFloat("material.shininess", 32.0f);
+        // No shadows (shadowCascadeCount stays 0, lamps have no shadowIndex), but the samplers must not
+        // share unit 0 with the sampler2Ds
+        shader.setInt("shadowCascades", SHADOW_CASCADES_UNIT);
+        shader.setInt("pointShadowAtlas", POINT_SHADOWS_UNIT);
+
+        // Small lamps with a short range (about 2.5 units), like the table and floor lamps of the house
+        // ------------------------------
+        srand(1);
+        std::cout << "lights  build ms  lights/cluster (max)  brute force ms  clustered ms" << std::endl;
+        unsigned int counts[] = { 16, 32, 64, 128, 200, 256 };
+        for (unsigned int c = 0; c < sizeof(counts) / sizeof(counts[0]); c++)
+        {
+            lightBuffer.clearPoints();
+            for (unsigned int i = 0; i < counts[c]; i++)
+                lightBuffer.addPoint(LightPoint(glm::vec3(randomRange(-4.5f, 4.5f), randomRange(0.1f, 1.5f), randomRange(-4.5f, 4.5f)),
+                    0.0f, 0.3f, 0.3f, 1.0f, 0.7f, 1.8f));
+            lightBuffer.update();
+
+            std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+            for (int frame = 0; frame < frames; frame++)
+                lightClusters.build(view, lightBuffer);
+            std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+            lightClusters.bind(shader);
+
+            shader.setInt("clusteredLighting", 0);
+            double bruteForce = drawFloorMs(shader, floorVAO, query, frames);
+            shader.setInt("clusteredLighting", 1);
+            double clustered = drawFloorMs(shader, floorVAO, query, frames);
+
+            std::cout << counts[c] << "  " << elapsed.count() / frames << "  "
+                << (float)lightClusters.lightIndexCount / CLUSTER_COUNT << " (" << lightClusters.maxLightsPerCluster << ")  "
+                << bruteForce << "  " << clustered << std::endl;
+        }
+
+        glDeleteQueries(1, &query);
+        glDeleteVertexArrays(1, &floorVAO);
+        glDeleteBuffers(1, &floorVBO);
+    }
+    glfwTerminate();
+    return 0;
+}
@@ -7,14 +7,47 @@ out vec2 TexCoords;
 out vec3 FragPos;
 out vec3 Normal;
 
+// Bit exact between programs, the depth prepass (main.cpp) draws with this shader and the forward
+// pass tests against it with GL_EQUAL
+invariant gl_Position;
+
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+// Normals through model, computed once per object on the CPU (computeNormalMatrix in SceneObject.h)
+uniform mat3 normalMatrix;
+// FrameConstants in UniformBlocks.h, written once per frame
+layout (std140) uniform FrameConstants
+{
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec4 viewPos;
+};
+
+// Attribute encoding, see VertexLayout in Mesh.h: 0 = floats, 1 = CompactVertex
+uniform int vertexFormat;
+// CompactVertex positions are normalized to the mesh AABB
+uniform vec3 positionOffset;
+uniform vec3 positionScale;
+
+vec3 octahedralDecode(vec2 e)
+{
+    vec3 n = vec3(e, 1.0f - abs(e.x) - abs(e.y));
+    if (n.z < 0.0f)
+        n.xy = (1.0f - abs(n.yx)) * vec2(n.x >= 0.0f ? 1.0f : -1.0f, n.y >= 0.0f ? 1.0f : -1.0f);
+    return normalize(n);
+}
 
 void main()
 {
-    gl_Position = projection * view * model * vec4(position, 1.0f);
-    FragPos = vec3(model * vec4(position, 1.0f));
-    Normal = mat3(transpose(inverse(model))) * normal;
+    vec3 localPosition = position;
+    vec3 localNormal = normal;
+    if (vertexFormat == 1)
+    {
+        localPosition = positionOffset + position * positionScale;
+        localNormal = octahedralDecode(normal.xy);
+    }
+    gl_Position = viewProjection * model * vec4(localPosition, 1.0f);
+    FragPos = vec3(model * vec4(localPosition, 1.0f));
+    Normal = normalMatrix * localNormal;
     TexCoords = texCoords;
 }
\ No newline at end of file
@@ -0,0 +1,43 @@
+#version 330 core
+#include "lighting.glsl"
+
+out vec4 color;
+
+// Targets of GBuffer.h, filled by gBufferFragmentShader.frag
+uniform sampler2D gAlbedoSpecular;
+uniform sampler2D gNormalShininess;
+uniform sampler2D gDepth;
+uniform mat4 inverseViewProjection;
+
+vec3 octahedralDecode(vec2 e)
+{
+    vec3 n = vec3(e, 1.0f - abs(e.x) - abs(e.y));
+    if (n.z < 0.0f)
+        n.xy = (1.0f - abs(n.yx)) * vec2(n.x >= 0.0f ? 1.0f : -1.0f, n.y >= 0.0f ? 1.0f : -1.0f);
+    return normalize(n);
+}
+
+void main()
+{
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    float depth = texelFetch(gDepth, texel, 0).r;
+    // Nothing drawn here, keep the skybox
+    if (depth == 1.0f)
+        discard;
+    vec4 albedoSpecular = texelFetch(gAlbedoSpecular, texel, 0);
+    vec4 normalShininess = texelFetch(gNormalShininess, texel, 0);
+
+    // World position from the depth buffer
+    vec2 ndc = gl_FragCoord.xy / vec2(textureSize(gDepth, 0)) * 2.0f - 1.0f;
+    vec4 position = inverseViewProjection * vec4(ndc, depth * 2.0f - 1.0f, 1.0f);
+    vec3 fragPos = position.xyz / position.w;
+
+    vec3 uNormal = octahedralDecode(normalShininess.xy * 2.0f - 1.0f);
+    vec3 viewDir = normalize(viewPos.xyz - fragPos); // from fragPos to Camera
+    Surface surface;
+    surface.albedo = albedoSpecular.rgb;
+    surface.specular = vec3(albedoSpecular.a);
+    surface.shininess = floor(normalShininess.z * 1023.0f + 0.5f);
+
+    color = vec4(CalcLighting(surface, uNormal, fragPos, viewDir), 1.0);
+}
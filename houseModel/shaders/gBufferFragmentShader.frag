@@ -0,0 +1,34 @@
+#version 330 core
+struct Material {
+    sampler2D diffuse;
+    sampler2D specular;
+    float shininess;
+}; 
+
+in vec3 FragPos;
+in vec3 Normal;
+in vec2 TexCoords;
+
+// Targets of GBuffer.h
+layout (location = 0) out vec4 albedoSpecular;
+layout (location = 1) out vec4 normalShininess;
+
+uniform Material material;
+
+// Inverse of octahedralDecode in VertexShader.vs, mapped to [0, 1] for the unorm target
+vec2 octahedralEncode(vec3 n)
+{
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    vec2 e = n.xy;
+    if (n.z < 0.0f)
+        e = (1.0f - abs(n.yx)) * vec2(n.x >= 0.0f ? 1.0f : -1.0f, n.y >= 0.0f ? 1.0f : -1.0f);
+    return e * 0.5f + 0.5f;
+}
+
+void main()
+{
+    // Specular maps of the house are grey, one channel is kept
+    albedoSpecular = vec4(vec3(texture(material.diffuse, TexCoords)), texture(material.specular, TexCoords).r);
+    // Shininess is stored as an integer in the 10 bit channel
+    normalShininess = vec4(octahedralEncode(normalize(Normal)), min(material.shininess, 1023.0f) / 1023.0f, 0.0f);
+}
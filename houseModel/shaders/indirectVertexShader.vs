@@ -0,0 +1,63 @@
+#version 430 core
+layout (location = 0) in vec3 position;
+layout (location = 1) in vec3 normal;
+layout (location = 2) in vec2 texCoords;
+// Instanced attribute holding the command's baseInstance, see IndirectBatch
+layout (location = 3) in uint drawID;
+
+out vec2 TexCoords;
+out vec3 FragPos;
+out vec3 Normal;
+
+// The depth prepass (main.cpp) draws the batch with this shader too, the color pass tests against it
+// with GL_EQUAL
+invariant gl_Position;
+
+// DrawParameters in IndirectBatch.h
+struct DrawParameters
+{
+    mat4 model;
+    // xyz: CompactVertex position decode, w: vertex format (0 = floats, 1 = CompactVertex)
+    vec4 positionOffset;
+    vec4 positionScale;
+    // Normal matrix of model from the CPU (computeNormalMatrix in SceneObject.h), one column per vec4
+    vec4 normalMatrix[3];
+};
+
+layout (std430, binding = 0) readonly buffer DrawData
+{
+    DrawParameters draws[];
+};
+
+// FrameConstants in UniformBlocks.h, written once per frame
+layout (std140) uniform FrameConstants
+{
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec4 viewPos;
+};
+
+vec3 octahedralDecode(vec2 e)
+{
+    vec3 n = vec3(e, 1.0f - abs(e.x) - abs(e.y));
+    if (n.z < 0.0f)
+        n.xy = (1.0f - abs(n.yx)) * vec2(n.x >= 0.0f ? 1.0f : -1.0f, n.y >= 0.0f ? 1.0f : -1.0f);
+    return normalize(n);
+}
+
+void main()
+{
+    DrawParameters draw = draws[drawID];
+    vec3 localPosition = position;
+    vec3 localNormal = normal;
+    if (draw.positionOffset.w == 1.0f)
+    {
+        localPosition = draw.positionOffset.xyz + position * draw.positionScale.xyz;
+        localNormal = octahedralDecode(normal.xy);
+    }
+    gl_Position = viewProjection * draw.model * vec4(localPosition, 1.0f);
+    FragPos = vec3(draw.model * vec4(localPosition, 1.0f));
+    Normal = mat3(draw.normalMatrix[0].xyz, draw.normalMatrix[1].xyz, draw.normalMatrix[2].xyz) * localNormal;
+    TexCoords = texCoords;
+}
@@ -0,0 +1,261 @@
+// Scene lighting shared by the forward (FragmentShader.frag) and deferred (deferredLightingShader.frag)
+// paths, pulled in with #include, see Shader::expandIncludes
+
+// std140 layouts, GPUDirLight/GPUPointLight/GPUSpotLight in LightBuffer.h
+struct DirLight {
+    vec3 direction;
+	
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+
+struct PointLight {
+    vec3 position;
+    float constant;
+    vec3 ambient;
+    float linear;
+    vec3 diffuse;
+    float quadratic;
+    vec3 specular;
+    // Slot in pointShadowMaps, negative casts no shadow
+    float shadowIndex;
+};
+
+struct SpotLight {
+    vec3 position;
+    float innerCutOff;
+    vec3 direction;
+    float outerCutOff;
+    vec3 ambient;
+    float constant;
+    vec3 diffuse;
+    float linear;
+    vec3 specular;
+    float quadratic;
+};
+
+// Material values at the shaded point, sampled from the textures or read back from the G-buffer
+struct Surface {
+    vec3 albedo;
+    vec3 specular;
+    float shininess;
+};
+
+// LightBuffer::MAX_POINT_LIGHTS, only pointLightCount of them are used
+#define MAX_POINT_LIGHTS 256
+
+// FrameConstants in UniformBlocks.h, written once per frame
+layout (std140) uniform FrameConstants
+{
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec4 viewPos;
+};
+
+// Written by LightBuffer only when a light changes
+layout (std140) uniform Lights
+{
+    DirLight dirLight;
+    SpotLight spotLight;
+    int pointLightCount;
+    int spotLightEnabled;
+};
+
+layout (std140) uniform PointLights
+{
+    PointLight pointLights[MAX_POINT_LIGHTS];
+};
+
+// Clustered lighting, LightClusters.h: per froxel (offset, count) into a list of point light indices
+uniform bool clusteredLighting;
+uniform usamplerBuffer clusterGrid;
+uniform usamplerBuffer clusterLights;
+uniform vec2 clusterTileSize;
+uniform vec2 clusterDepthScaleBias;
+const ivec3 CLUSTER_GRID = ivec3(16, 9, 24);
+
+// Cascaded shadow map of dirLight, CascadedShadowMap.h; no shadows while shadowCascadeCount is 0
+#define MAX_SHADOW_CASCADES 4
+uniform sampler2DArrayShadow shadowCascades;
+uniform int shadowCascadeCount;
+uniform mat4 cascadeLightSpace[MAX_SHADOW_CASCADES];
+// View depth each cascade ends at
+uniform float cascadeSplits[MAX_SHADOW_CASCADES];
+// World size of about a texel of each cascade
+uniform float cascadeNormalOffsets[MAX_SHADOW_CASCADES];
+// Part of a cascade over which it fades into the next
+uniform float cascadeBlend;
+
+// Lit fraction of fragPos in one cascade, 3x3 taps of the hardware compare
+float SampleCascade(int cascade, vec3 fragPos, vec3 normal)
+{
+    vec4 lightSpace = cascadeLightSpace[cascade] * vec4(fragPos + normal * cascadeNormalOffsets[cascade], 1.0);
+    vec3 coords = lightSpace.xyz / lightSpace.w * 0.5 + 0.5;
+    if (coords.z > 1.0)
+        return 1.0;
+    vec2 texelSize = 1.0 / vec2(textureSize(shadowCascades, 0).xy);
+    float lit = 0.0;
+    for (int x = -1; x <= 1; x++)
+        for (int y = -1; y <= 1; y++)
+            lit += texture(shadowCascades, vec4(coords.xy + vec2(x, y) * texelSize, float(cascade), coords.z));
+    return lit / 9.0;
+}
+
+// Lit fraction of fragPos for the directional light
+float CalcDirShadow(vec3 fragPos, vec3 normal)
+{
+    float viewDepth = -(view * vec4(fragPos, 1.0)).z;
+    int cascade = 0;
+    while (cascade < shadowCascadeCount && viewDepth > cascadeSplits[cascade])
+        cascade++;
+    // Beyond the shadow distance, or no shadows at all
+    if (cascade == shadowCascadeCount)
+        return 1.0;
+    float lit = SampleCascade(cascade, fragPos, normal);
+    float cascadeStart = cascade == 0 ? 0.0 : cascadeSplits[cascade - 1];
+    float fade = (cascadeSplits[cascade] - viewDepth) / max((cascadeSplits[cascade] - cascadeStart) * cascadeBlend, 1e-4);
+    if (fade < 1.0 && cascade + 1 < shadowCascadeCount)
+        lit = mix(SampleCascade(cascade + 1, fragPos, normal), lit, fade);
+    return lit;
+}
+
+// Point light shadows, PointShadowMaps.h: one atlas with six tiles per light in cube map face order,
+// holding distance to the light / pointShadowFarPlane
+#define MAX_POINT_SHADOWS 16
+uniform sampler2DShadow pointShadowAtlas;
+// Per light and face (x, y, size) of the tile in atlas coordinates, size 0 when it got none this frame
+uniform vec4 pointShadowTiles[MAX_POINT_SHADOWS * 6];
+uniform float pointShadowFarPlane;
+
+// Lit fraction of fragPos for the point light at lightPosition
+float CalcPointShadow(int shadowIndex, vec3 lightPosition, vec3 fragPos, vec3 normal)
+{
+    vec3 toFrag = fragPos + normal * 0.02 - lightPosition;
+    float distance = length(toFrag);
+    if (distance >= pointShadowFarPlane)
+        return 1.0;
+    // Face selection and coordinates of the GL cube map rules, as there are no cube map arrays in 3.3
+    vec3 absolute = abs(toFrag);
+    int face;
+    float major;
+    vec2 st;
+    if (absolute.x >= absolute.y && absolute.x >= absolute.z)
+    {
+        face = toFrag.x > 0.0 ? 0 : 1;
+        major = absolute.x;
+        st = vec2(toFrag.x > 0.0 ? -toFrag.z : toFrag.z, -toFrag.y);
+    }
+    else if (absolute.y >= absolute.z)
+    {
+        face = toFrag.y > 0.0 ? 2 : 3;
+        major = absolute.y;
+        st = vec2(toFrag.x, toFrag.y > 0.0 ? toFrag.z : -toFrag.z);
+    }
+    else
+    {
+        face = toFrag.z > 0.0 ? 4 : 5;
+        major = absolute.z;
+        st = vec2(toFrag.z > 0.0 ? toFrag.x : -toFrag.x, -toFrag.y);
+    }
+    vec4 tile = pointShadowTiles[shadowIndex * 6 + face];
+    if (tile.z == 0.0)
+        return 1.0;
+    // Half a texel in from the edges, so filtering never reads the neighbour tile
+    float halfTexel = 0.5 / float(textureSize(pointShadowAtlas, 0).x);
+    vec2 uv = tile.xy + clamp((st / major * 0.5 + 0.5) * tile.z, vec2(halfTexel), vec2(tile.z - halfTexel));
+    return texture(pointShadowAtlas, vec3(uv, distance / pointShadowFarPlane - 0.002));
+}
+
+// Calculates the color when using a directional light, shadow is the lit fraction.
+vec3 CalcDirLight(DirLight light, Surface surface, vec3 normal, vec3 viewDir, float shadow)
+{
+    vec3 dirToLight = normalize(-light.direction);
+    // Diffuse shading
+    float diffIntensity = max(dot(normal, dirToLight), 0.0);
+    // Specular shading
+    vec3 reflectDir = reflect(-dirToLight, normal);
+    float specIntensity = pow(max(dot(viewDir, reflectDir), 0.0), surface.shininess);
+    // Combine results
+    vec3 ambientColor = light.ambient * surface.albedo;
+    vec3 diffuseColor = light.diffuse * diffIntensity * surface.albedo;
+    vec3 specularColor = light.specular * specIntensity * surface.specular;
+    return (ambientColor + shadow * (diffuseColor + specularColor));
+}
+
+// Calculates the color when using a point light.
+vec3 CalcPointLight(PointLight light, Surface surface, vec3 normal, vec3 fragPos, vec3 viewDir)
+{
+    vec3 dirFragToLight = normalize(light.position - fragPos);
+    // Diffuse shading
+    float diffIntensity = max(dot(normal, dirFragToLight), 0.0);
+    // Specular shading
+    vec3 reflectDir = reflect(-dirFragToLight, normal);
+    float specIntensity = pow(max(dot(viewDir, reflectDir), 0.0), surface.shininess);
+    // Attenuation
+    float distance = length(light.position - fragPos);
+    float attenuation = 1.0f / (light.constant + light.linear * distance + light.quadratic * (distance * distance));    
+    // Combine results
+    vec3 ambientColor = light.ambient * surface.albedo;
+    vec3 diffuseColor = light.diffuse * diffIntensity * surface.albedo;
+    vec3 specularColor = light.specular * specIntensity * surface.specular;
+    ambientColor *= attenuation;
+    diffuseColor *= attenuation;
+    specularColor *= attenuation;
+    float shadow = light.shadowIndex >= 0.0 ? CalcPointShadow(int(light.shadowIndex), light.position, fragPos, normal) : 1.0;
+    return (ambientColor + shadow * (diffuseColor + specularColor));
+}
+
+// Calculates the color when using a spot light.
+vec3 CalcSpotLight(SpotLight light, Surface surface, vec3 normal, vec3 fragPos, vec3 viewDir)
+{
+    vec3 dirFragToLight = normalize(light.position - fragPos);
+    // Diffuse shading
+    float diffIntensity = max(dot(normal, dirFragToLight), 0.0);
+    // Specular shading
+    vec3 reflectDir = reflect(-dirFragToLight, normal);
+    float specIntensity = pow(max(dot(viewDir, reflectDir), 0.0), surface.shininess);
+    // Attenuation
+    float distance = length(light.position - fragPos);
+    float attenuation = 1.0f / (light.constant + light.linear * distance + light.quadratic * (distance * distance));    
+    // Spotlight intensity
+    float theta = dot(dirFragToLight, normalize(-light.direction)); 
+    float epsilon = light.innerCutOff - light.outerCutOff;
+    float intensity = clamp((theta - light.outerCutOff) / epsilon, 0.0, 1.0);
+    // Combine results
+    vec3 ambientColor = light.ambient * surface.albedo;
+    vec3 diffuseColor = light.diffuse * diffIntensity * surface.albedo;
+    vec3 specularColor = light.specular * specIntensity * surface.specular;
+    ambientColor *= attenuation * intensity;
+    diffuseColor *= attenuation * intensity;
+    specularColor *= attenuation * intensity;
+    return (ambientColor + diffuseColor + specularColor);
+}
+
+// Sum of all lights of the scene at fragPos, which is the fragment at gl_FragCoord
+vec3 CalcLighting(Surface surface, vec3 normal, vec3 fragPos, vec3 viewDir)
+{
+    // Phase 1: Directional lighting
+    vec3 result = CalcDirLight(dirLight, surface, normal, viewDir, CalcDirShadow(fragPos, normal));
+    // Phase 2: Point lights
+    if (clusteredLighting)
+    {
+        // Only the lights whose range touches this fragment's froxel
+        float viewDepth = -(view * vec4(fragPos, 1.0)).z;
+        ivec3 cell = ivec3(ivec2(gl_FragCoord.xy / clusterTileSize), int(log(max(viewDepth, 1e-4)) * clusterDepthScaleBias.x + clusterDepthScaleBias.y));
+        cell = clamp(cell, ivec3(0), CLUSTER_GRID - 1);
+        uvec2 range = texelFetch(clusterGrid, cell.x + CLUSTER_GRID.x * (cell.y + CLUSTER_GRID.y * cell.z)).xy;
+        for(uint i = 0u; i < range.y; i++)
+            result += CalcPointLight(pointLights[texelFetch(clusterLights, int(range.x + i)).x], surface, normal, fragPos, viewDir);
+    }
+    else
+    {
+        for(int i = 0; i < pointLightCount; i++)
+            result += CalcPointLight(pointLights[i], surface, normal, fragPos, viewDir);    
+    }
+    // Phase 3: Spot light
+    if (spotLightEnabled != 0)
+        result += CalcSpotLight(spotLight, surface, normal, fragPos, viewDir);
+    return result;
+}
@@ -0,0 +1,11 @@
+#version 330 core
+in vec3 FragPos;
+
+uniform vec3 lightPosition;
+uniform float shadowFarPlane;
+
+void main()
+{
+    // Linear distance, so every face compares against the same value in CalcPointShadow
+    gl_FragDepth = length(FragPos - lightPosition) / shadowFarPlane;
+}
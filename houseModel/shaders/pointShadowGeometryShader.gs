@@ -0,0 +1,37 @@
+#version 330 core
+layout (triangles) in;
+layout (triangle_strip, max_vertices = 18) out;
+
+in vec3 WorldPos[];
+
+// Projection of every cube face of the light, PointShadowMaps::beginLight
+uniform mat4 shadowFaceMatrices[6];
+// Tile of every face in the atlas as (offset, scale) of normalized device coordinates
+uniform vec4 shadowFaceTiles[6];
+// Faces the object reaches, PointShadowMaps::faceMask
+uniform int faceMask;
+
+out vec3 FragPos;
+// Side planes of the face's frustum, the tile's edges once moved into the atlas
+out float gl_ClipDistance[4];
+
+void main()
+{
+    for (int face = 0; face < 6; face++)
+    {
+        if ((faceMask & (1 << face)) == 0)
+            continue;
+        for (int i = 0; i < 3; i++)
+        {
+            vec4 clip = shadowFaceMatrices[face] * vec4(WorldPos[i], 1.0);
+            gl_ClipDistance[0] = clip.w + clip.x;
+            gl_ClipDistance[1] = clip.w - clip.x;
+            gl_ClipDistance[2] = clip.w + clip.y;
+            gl_ClipDistance[3] = clip.w - clip.y;
+            FragPos = WorldPos[i];
+            gl_Position = vec4(clip.xy * shadowFaceTiles[face].z + shadowFaceTiles[face].xy * clip.w, clip.zw);
+            EmitVertex();
+        }
+        EndPrimitive();
+    }
+}
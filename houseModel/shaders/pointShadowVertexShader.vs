@@ -0,0 +1,21 @@
+#version 330 core
+layout (location = 0) in vec3 position;
+
+uniform mat4 model;
+
+// Attribute encoding, see VertexLayout in Mesh.h: 0 = floats, 1 = CompactVertex
+uniform int vertexFormat;
+// CompactVertex positions are normalized to the mesh AABB
+uniform vec3 positionOffset;
+uniform vec3 positionScale;
+
+out vec3 WorldPos;
+
+void main()
+{
+    vec3 localPosition = position;
+    if (vertexFormat == 1)
+        localPosition = positionOffset + position * positionScale;
+    // Projected per face in pointShadowGeometryShader.gs
+    WorldPos = vec3(model * vec4(localPosition, 1.0f));
+}
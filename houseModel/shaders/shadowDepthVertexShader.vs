@@ -0,0 +1,20 @@
+#version 330 core
+layout (location = 0) in vec3 position;
+
+uniform mat4 model;
+// Light projection of the cascade being rendered, CascadedShadowMap.h
+uniform mat4 lightSpaceMatrix;
+
+// Attribute encoding, see VertexLayout in Mesh.h: 0 = floats, 1 = CompactVertex
+uniform int vertexFormat;
+// CompactVertex positions are normalized to the mesh AABB
+uniform vec3 positionOffset;
+uniform vec3 positionScale;
+
+void main()
+{
+    vec3 localPosition = position;
+    if (vertexFormat == 1)
+        localPosition = positionOffset + position * positionScale;
+    gl_Position = lightSpaceMatrix * model * vec4(localPosition, 1.0f);
+}
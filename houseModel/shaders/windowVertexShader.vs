@@ -6,12 +6,18 @@ layout (location = 1) in vec2 texCoords;
 out vec2 TexCoords;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection; 
+// FrameConstants in UniformBlocks.h, written once per frame
+layout (std140) uniform FrameConstants
+{
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec4 viewPos;
+};
 
 void main()
 {
-    gl_Position = projection * view * model * vec4(aPos, 1.0f);
+    gl_Position = viewProjection * model * vec4(aPos, 1.0f);
     //gl_Position =vec4(aPos, 1.0f);
     TexCoords = texCoords;
 } 
\ No newline at end of file
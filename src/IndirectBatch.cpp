@@ -0,0 +1,264 @@
+#include "IndirectBatch.h"
+// Std. Includes
+#include <vector>
+#include <algorithm>
+#include <iostream>
+#include <cmath>
+
+// Same as computeNormalMatrix in houseModel/SceneObject.cpp: the upper 3x3 when it only rotates and
+// scales uniformly, its inverse transpose otherwise
+static glm::mat3 computeNormalMatrix(const glm::mat4& transform)
+{
+	glm::mat3 upper(transform);
+	float length0 = glm::dot(upper[0], upper[0]);
+	float tolerance = length0 * 1e-4f;
+	if (std::fabs(glm::dot(upper[1], upper[1]) - length0) <= tolerance && std::fabs(glm::dot(upper[2], upper[2]) - length0) <= tolerance
+		&& std::fabs(glm::dot(upper[0], upper[1])) <= tolerance && std::fabs(glm::dot(upper[1], upper[2])) <= tolerance
+		&& std::fabs(glm::dot(upper[0], upper[2])) <= tolerance)
+		return upper;
+	return glm::transpose(glm::inverse(upper));
+}
+
+IndirectBatch::IndirectBatch(MeshArena* arena)
+	: indirect(supported()), drawCount(0), submitCalls(0), arena(arena), commandsDirty(true), parametersDirty(true), visibilityDirty(false), arenaGeneration(0)
+{
+	glGenBuffers(1, &commandBuffer);
+	glGenBuffers(1, &parameterBuffer);
+	glGenBuffers(1, &drawIDBuffer);
+}
+
+IndirectBatch::~IndirectBatch()
+{
+	glDeleteBuffers(1, &commandBuffer);
+	glDeleteBuffers(1, &parameterBuffer);
+	glDeleteBuffers(1, &drawIDBuffer);
+}
+
+bool IndirectBatch::supported()
+{
+	GLint major = 0, minor = 0;
+	glGetIntegerv(GL_MAJOR_VERSION, &major);
+	glGetIntegerv(GL_MINOR_VERSION, &minor);
+	return major > 4 || (major == 4 && minor >= 3);
+}
+
+unsigned int IndirectBatch::add(const Model& model)
+{
+	Instance instance;
+	instance.firstDraw = (unsigned int)meshes.size();
+	for (unsigned int i = 0; i < model.meshes.size(); i++)
+	{
+		const Mesh& mesh = model.meshes[i];
+		if (mesh.arena != arena)
+		{
+			std::cout << "IndirectBatch: skipping a mesh of " << model.directory << " that isn't in the batch's arena" << std::endl;
+			continue;
+		}
+		DrawParameters drawParameters;
+		drawParameters.model = glm::mat4(1.0f);
+		drawParameters.positionOffset = glm::vec4(mesh.positionOffset, (float)mesh.format);
+		drawParameters.positionScale = glm::vec4(mesh.positionScale, 0.0f);
+		for (unsigned int column = 0; column < 3; column++)
+			drawParameters.normalMatrix[column] = glm::vec4(column == 0, column == 1, column == 2, 0.0f);
+		meshes.push_back(&mesh);
+		meshIndices.push_back(i);
+		drawVisible.push_back(1);
+		parameters.push_back(drawParameters);
+	}
+	instance.drawCount = (unsigned int)meshes.size() - instance.firstDraw;
+	instances.push_back(instance);
+	commandsDirty = true;
+	parametersDirty = true;
+	return (unsigned int)instances.size() - 1;
+}
+
+void IndirectBatch::setTransform(unsigned int instance, const glm::mat4& transform)
+{
+	const Instance& draws = instances[instance];
+	glm::mat3 normalMatrix = computeNormalMatrix(transform);
+	for (unsigned int i = draws.firstDraw; i < draws.firstDraw + draws.drawCount; i++)
+	{
+		parameters[i].model = transform;
+		for (unsigned int column = 0; column < 3; column++)
+			parameters[i].normalMatrix[column] = glm::vec4(normalMatrix[column], 0.0f);
+	}
+	parametersDirty = true;
+}
+
+void IndirectBatch::setVisible(unsigned int instance, bool visible, const unsigned char* visibleMeshes)
+{
+	const Instance& draws = instances[instance];
+	for (unsigned int i = draws.firstDraw; i < draws.firstDraw + draws.drawCount; i++)
+	{
+		unsigned char drawIsVisible = visible && (!visibleMeshes || visibleMeshes[meshIndices[i]]);
+		if (drawVisible[i] != drawIsVisible)
+		{
+			drawVisible[i] = drawIsVisible;
+			visibilityDirty = true;
+		}
+	}
+}
+
+// Sorts the draws by material so each material is one multi draw, then uploads the commands
+void IndirectBatch::buildCommands()
+{
+	std::vector<std::vector<unsigned int> > keys(meshes.size());
+	std::vector<unsigned int> order(meshes.size());
+	for (unsigned int i = 0; i < meshes.size(); i++)
+	{
+		keys[i] = meshes[i]->materialKey();
+		order[i] = i;
+	}
+	std::stable_sort(order.begin(), order.end(), [&keys](unsigned int a, unsigned int b) { return keys[a] < keys[b]; });
+
+	commands.clear();
+	groups.clear();
+	for (unsigned int i = 0; i < order.size(); i++)
+	{
+		unsigned int drawID = order[i];
+		const Mesh* mesh = meshes[drawID];
+		const MeshArena::Allocation& allocation = arena->allocation(mesh->arenaHandle);
+		DrawElementsIndirectCommand command;
+		command.count = mesh->indexCount;
+		command.instanceCount = drawVisible[drawID];
+		command.firstIndex = allocation.firstIndex;
+		command.baseVertex = (GLint)allocation.baseVertex;
+		command.baseInstance = drawID;
+		if (groups.empty() || keys[order[i - 1]] != keys[drawID])
+		{
+			Group group;
+			group.material = mesh;
+			group.firstCommand = (unsigned int)commands.size();
+			group.commandCount = 0;
+			groups.push_back(group);
+		}
+		groups.back().commandCount++;
+		commands.push_back(command);
+	}
+
+	if (indirect)
+	{
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+		glBufferData(GL_DRAW_INDIRECT_BUFFER, commands.size() * sizeof(DrawElementsIndirectCommand), commands.data(), GL_STATIC_DRAW);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+		// Instanced attribute values are baseInstance + instance, with one instance per command that is the draw ID
+		std::vector<GLuint> drawIDs(meshes.size());
+		for (unsigned int i = 0; i < drawIDs.size(); i++)
+			drawIDs[i] = i;
+		glBindBuffer(GL_ARRAY_BUFFER, drawIDBuffer);
+		glBufferData(GL_ARRAY_BUFFER, drawIDs.size() * sizeof(GLuint), drawIDs.data(), GL_STATIC_DRAW);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+	commandsDirty = false;
+	visibilityDirty = false;
+	arenaGeneration = arena->generation();
+}
+
+// Hidden draws only change their instanceCount, the order and the groups stay
+void IndirectBatch::updateVisibility()
+{
+	for (unsigned int i = 0; i < commands.size(); i++)
+		commands[i].instanceCount = drawVisible[commands[i].baseInstance];
+	if (indirect)
+	{
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+		glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, commands.size() * sizeof(DrawElementsIndirectCommand), commands.data());
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	}
+	visibilityDirty = false;
+}
+
+void IndirectBatch::draw(Shader* shader)
+{
+	submit(shader, true);
+}
+
+void IndirectBatch::drawDepth(Shader* shader)
+{
+	submit(shader, false);
+}
+
+void IndirectBatch::submit(Shader* shader, bool materials)
+{
+	drawCount = 0;
+	submitCalls = 0;
+	if (meshes.empty())
+		return;
+	if (commandsDirty || arenaGeneration != arena->generation())
+		buildCommands();
+	else if (visibilityDirty)
+		updateVisibility();
+	for (unsigned int i = 0; i < commands.size(); i++)
+		drawCount += commands[i].instanceCount;
+
+	// Depth draws read the arena's position stream, the shader's other attributes are then constant
+	glBindVertexArray(materials ? arena->vertexArray() : arena->depthVertexArray());
+	if (indirect)
+	{
+		if (parametersDirty)
+		{
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, parameterBuffer);
+			glBufferData(GL_SHADER_STORAGE_BUFFER, parameters.size() * sizeof(DrawParameters), parameters.data(), GL_DYNAMIC_DRAW);
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+			parametersDirty = false;
+		}
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, parameterBuffer);
+		glBindBuffer(GL_ARRAY_BUFFER, drawIDBuffer);
+		glEnableVertexAttribArray(3);
+		glVertexAttribIPointer(3, 1, GL_UNSIGNED_INT, sizeof(GLuint), (void*)0);
+		glVertexAttribDivisor(3, 1);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+		if (materials)
+		{
+			for (unsigned int i = 0; i < groups.size(); i++)
+			{
+				groups[i].material->bindMaterial(shader);
+				glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (void*)(size_t)(groups[i].firstCommand * sizeof(DrawElementsIndirectCommand)), groups[i].commandCount, 0);
+				groups[i].material->unbindMaterial();
+				submitCalls++;
+			}
+		}
+		else
+		{
+			glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (void*)0, (GLsizei)commands.size(), 0);
+			submitCalls++;
+		}
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+		// The arena VAO is shared with Mesh::Draw, whose attributes are all per vertex
+		glVertexAttribDivisor(3, 0);
+		glDisableVertexAttribArray(3);
+	}
+	else
+	{
+		Uniform<glm::mat4> modelUniform = shader->uniform<glm::mat4>("model");
+		Uniform<glm::mat3> normalMatrixUniform = shader->uniform<glm::mat3>("normalMatrix");
+		Uniform<int> formatUniform = shader->uniform<int>("vertexFormat");
+		Uniform<glm::vec3> offsetUniform = shader->uniform<glm::vec3>("positionOffset");
+		Uniform<glm::vec3> scaleUniform = shader->uniform<glm::vec3>("positionScale");
+		for (unsigned int i = 0; i < groups.size(); i++)
+		{
+			if (materials)
+				groups[i].material->bindMaterial(shader);
+			for (unsigned int c = groups[i].firstCommand; c < groups[i].firstCommand + groups[i].commandCount; c++)
+			{
+				const DrawElementsIndirectCommand& command = commands[c];
+				if (command.instanceCount == 0)
+					continue;
+				const DrawParameters& drawParameters = parameters[command.baseInstance];
+				modelUniform.set(drawParameters.model);
+				normalMatrixUniform.set(glm::mat3(glm::vec3(drawParameters.normalMatrix[0]), glm::vec3(drawParameters.normalMatrix[1]), glm::vec3(drawParameters.normalMatrix[2])));
+				formatUniform.set((int)drawParameters.positionOffset.w);
+				offsetUniform.set(glm::vec3(drawParameters.positionOffset));
+				scaleUniform.set(glm::vec3(drawParameters.positionScale));
+				glDrawElementsBaseVertex(GL_TRIANGLES, command.count, GL_UNSIGNED_INT, (void*)(size_t)(command.firstIndex * sizeof(GLuint)), command.baseVertex);
+				submitCalls++;
+			}
+			if (materials)
+				groups[i].material->unbindMaterial();
+		}
+		formatUniform.set(VERTEX_FORMAT_STANDARD);
+	}
+	glBindVertexArray(0);
+}
@@ -0,0 +1,103 @@
+#pragma once
+// Std. Includes
+#include <vector>
+
+// GL Includes
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "Mesh.h"
+#include "MeshArena.h"
+#include "Model.h"
+#include "Shader.h"
+
+// Layout glMultiDrawElementsIndirect reads from GL_DRAW_INDIRECT_BUFFER
+struct DrawElementsIndirectCommand {
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+};
+
+// std430 per draw data of indirectVertexShader.vs
+struct DrawParameters {
+    glm::mat4 model;
+    // xyz: compact position decode (see Mesh.h), w: VertexFormat
+    glm::vec4 positionOffset;
+    glm::vec4 positionScale;
+    // Columns of the normal matrix of model, vec4 so std430 lays them out like C++ does
+    glm::vec4 normalMatrix[3];
+};
+
+// Draws many models that live in one MeshArena with a glMultiDrawElementsIndirect per material,
+// instead of a glDrawElements (plus uniform and texture calls) per mesh. The commands are built
+// once and only rebuilt when models are added or the arena moved its allocations; per frame only
+// the transforms are uploaded. Each command's baseInstance is its draw ID, which reaches the
+// shader as an instanced attribute (location 3) and indexes the DrawParameters storage buffer, so
+// no gl_DrawID (GL 4.6) is needed. Without GL 4.3 the same batch falls back to one
+// glDrawElementsBaseVertex per mesh with the regular VertexShader.vs uniforms.
+class IndirectBatch {
+    public:
+        explicit IndirectBatch(MeshArena* arena);
+        ~IndirectBatch();
+
+        // GL 4.3: multi draw indirect and shader storage buffers
+        static bool supported();
+
+        // Adds every mesh of model (they have to be allocated from the batch's arena),
+        // returns the instance setTransform takes
+        unsigned int add(const Model& model);
+        void setTransform(unsigned int instance, const glm::mat4& transform);
+        // Hides all draws of an instance, or with visibleMeshes (one flag per mesh of the model, as
+        // FrustumCuller gives them) only some; hidden commands stay in place with an instanceCount of 0
+        void setVisible(unsigned int instance, bool visible, const unsigned char* visibleMeshes = 0);
+        // shader: indirectVertexShader.vs when indirect, VertexShader.vs otherwise
+        void draw(Shader* shader);
+        // Positions only for depth passes: no textures or material uniforms, so every command goes
+        // in a single multi draw
+        void drawDepth(Shader* shader);
+
+        // Set by the constructor from supported(), may be cleared to force the fallback
+        bool indirect;
+
+        // Statistics of the last draw: visible commands and the GL calls that submitted them
+        unsigned int drawCount;
+        unsigned int submitCalls;
+
+    private:
+        IndirectBatch(const IndirectBatch&);
+        IndirectBatch& operator=(const IndirectBatch&);
+
+        struct Instance {
+            unsigned int firstDraw;
+            unsigned int drawCount;
+        };
+        // Consecutive commands sharing a material
+        struct Group {
+            const Mesh* material;
+            unsigned int firstCommand;
+            unsigned int commandCount;
+        };
+
+        void buildCommands();
+        void updateVisibility();
+        void submit(Shader* shader, bool materials);
+
+        MeshArena* arena;
+        // Indexed by draw ID
+        std::vector<const Mesh*> meshes;
+        // Index of the mesh in its model, for setVisible
+        std::vector<unsigned int> meshIndices;
+        std::vector<unsigned char> drawVisible;
+        std::vector<DrawParameters> parameters;
+        std::vector<Instance> instances;
+        // Sorted by material
+        std::vector<DrawElementsIndirectCommand> commands;
+        std::vector<Group> groups;
+        bool commandsDirty;
+        bool parametersDirty;
+        bool visibilityDirty;
+        unsigned int arenaGeneration;
+        GLuint commandBuffer, parameterBuffer, drawIDBuffer;
+};
@@ -1,4 +1,5 @@
 #include "Mesh.h"
+#include "MeshArena.h"
 #include "Shader.h"
 // Std. Includes
 #include <string>
@@ -6,13 +7,108 @@
 #include <sstream>
 #include <iostream>
 #include <vector>
+#include <cmath>
+#include <algorithm>
+#include <cstddef>
 
 // GL Includes
 //#include <GL/glew.h> // Contains all the necessery OpenGL includes
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/packing.hpp>
 
-Mesh::Mesh(float vertices[])
+const VertexLayout& VertexLayout::get(VertexFormat format)
+{
+	static const VertexLayout standard = { sizeof(Vertex), 3, {
+		{ 0, 3, GL_FLOAT, GL_FALSE, offsetof(Vertex, Position) },
+		{ 1, 3, GL_FLOAT, GL_FALSE, offsetof(Vertex, Normal) },
+		{ 2, 2, GL_FLOAT, GL_FALSE, offsetof(Vertex, TexCoords) } } };
+	static const VertexLayout compact = { sizeof(CompactVertex), 3, {
+		{ 0, 3, GL_UNSIGNED_SHORT, GL_TRUE, offsetof(CompactVertex, Position) },
+		{ 1, 2, GL_SHORT, GL_TRUE, offsetof(CompactVertex, Normal) },
+		{ 2, 2, GL_HALF_FLOAT, GL_FALSE, offsetof(CompactVertex, TexCoords) } } };
+	return format == VERTEX_FORMAT_COMPACT ? compact : standard;
+}
+
+const VertexLayout& VertexLayout::positions(VertexFormat format)
+{
+	static const VertexLayout standard = { sizeof(glm::vec3), 1, {
+		{ 0, 3, GL_FLOAT, GL_FALSE, 0 } } };
+	// w stays in as padding, so every position starts 4 byte aligned
+	static const VertexLayout compact = { sizeof(CompactVertex::Position), 1, {
+		{ 0, 3, GL_UNSIGNED_SHORT, GL_TRUE, 0 } } };
+	return format == VERTEX_FORMAT_COMPACT ? compact : standard;
+}
+
+// Uniform names Draw looks up in the shader's UniformTable, built once instead of per draw
+static const std::string vertexFormatName("vertexFormat");
+static const std::string positionOffsetName("positionOffset");
+static const std::string positionScaleName("positionScale");
+static const std::string shininessName("material.shininess");
+
+// "texture_diffuse1", "texture_specular2", ..., grown on first use of a number
+static const std::string& samplerName(const std::string& type, GLuint number)
+{
+	static std::vector<std::string> diffuseNames, specularNames;
+	std::vector<std::string>& names = type == "texture_diffuse" ? diffuseNames : specularNames;
+	while (names.size() < number)
+		names.push_back(type + std::to_string(names.size() + 1));
+	return names[number - 1];
+}
+
+// Octahedral mapping of a unit vector to [-1, 1]^2, the lower hemisphere is folded over the diagonals
+static glm::vec2 octahedralEncode(glm::vec3 n)
+{
+	float l1 = std::fabs(n.x) + std::fabs(n.y) + std::fabs(n.z);
+	if (l1 <= 0.0f)
+		return glm::vec2(0.0f, 0.0f);
+	n /= l1;
+	glm::vec2 encoded(n.x, n.y);
+	if (n.z < 0.0f)
+	{
+		encoded.x = (1.0f - std::fabs(n.y)) * (n.x >= 0.0f ? 1.0f : -1.0f);
+		encoded.y = (1.0f - std::fabs(n.x)) * (n.y >= 0.0f ? 1.0f : -1.0f);
+	}
+	return encoded;
+}
+
+// Packs vertices into CompactVertex, returns the AABB the positions are quantized against
+static std::vector<CompactVertex> compactVertices(const Vertex* vertexData, unsigned int vertexCount, glm::vec3& boundsMin, glm::vec3& boundsExtent)
+{
+	boundsMin = glm::vec3(0.0f);
+	boundsExtent = glm::vec3(0.0f);
+	if (vertexCount == 0)
+		return std::vector<CompactVertex>();
+	glm::vec3 boundsMax = vertexData[0].Position;
+	boundsMin = vertexData[0].Position;
+	for (unsigned int i = 1; i < vertexCount; i++)
+	{
+		boundsMin = glm::min(boundsMin, vertexData[i].Position);
+		boundsMax = glm::max(boundsMax, vertexData[i].Position);
+	}
+	boundsExtent = boundsMax - boundsMin;
+	// Flat axes (extent 0) quantize to 0 and decode to boundsMin
+	glm::vec3 inverseExtent;
+	for (int axis = 0; axis < 3; axis++)
+		inverseExtent[axis] = boundsExtent[axis] > 0.0f ? 1.0f / boundsExtent[axis] : 0.0f;
+
+	std::vector<CompactVertex> compact(vertexCount);
+	for (unsigned int i = 0; i < vertexCount; i++)
+	{
+		glm::vec3 position = (vertexData[i].Position - boundsMin) * inverseExtent;
+		glm::vec2 normal = octahedralEncode(vertexData[i].Normal);
+		for (int axis = 0; axis < 3; axis++)
+			compact[i].Position[axis] = glm::packUnorm1x16(position[axis]);
+		compact[i].Position[3] = 0;
+		compact[i].Normal[0] = (short)glm::packSnorm1x16(normal.x);
+		compact[i].Normal[1] = (short)glm::packSnorm1x16(normal.y);
+		compact[i].TexCoords[0] = glm::packHalf1x16(vertexData[i].TexCoords.x);
+		compact[i].TexCoords[1] = glm::packHalf1x16(vertexData[i].TexCoords.y);
+	}
+	return compact;
+}
+
+Mesh::Mesh(float vertices[]) : arena(0), arenaHandle(0), format(VERTEX_FORMAT_STANDARD)
 {
 	this->vertices.resize(36);
 	memcpy(&(this->vertices[0]), vertices, 36 * 8 * sizeof(float));
@@ -20,18 +116,32 @@ Mesh::Mesh(float vertices[])
 	setUpMesh();
 }
 
-Mesh::Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<Texture> textures)
+Mesh::Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<Texture> textures, VertexFormat format, MeshArena* arena)
+	: arena(arena), arenaHandle(0), format(arena ? arena->format() : format)
 {
-	this->vertices = vertices;
-	this->indices = indices;
+	this->vertices = std::move(vertices);
+	this->indices = std::move(indices);
 	this->textures = textures;
 	setUpMesh();
 }
 
+Mesh::Mesh(const Vertex* vertices, unsigned int vertexCount, const unsigned int* indices, unsigned int indexCount, std::vector<Texture> textures, VertexFormat format, MeshArena* arena)
+	: arena(arena), arenaHandle(0), format(arena ? arena->format() : format)
+{
+	this->textures = textures;
+	setUpMesh(vertices, vertexCount, indices, indexCount);
+}
+
 Mesh::~Mesh()
 {
 }
 
+void Mesh::releaseArenaSpace()
+{
+	if (arena)
+		arena->release(arenaHandle);
+}
+
 //void Mesh::Draw(Shader* shader)
 //{
 //	for (unsigned int i = 0; i < textures.size(); i++) {
@@ -55,7 +165,58 @@ Mesh::~Mesh()
 //	glActiveTexture(GL_TEXTURE0);
 //}
 
-void Mesh::Draw(Shader* shader)
+void Mesh::Draw(Shader* shader, MeshletCuller* culler, bool vertexArrayBound)
+{
+	bindMaterial(shader);
+	bindVertexFormat(shader);
+
+	// Draw mesh
+	if (!vertexArrayBound)
+		glBindVertexArray(this->arena ? this->arena->vertexArray() : this->VAO);
+	if (culler && !this->meshlets.empty())
+		drawMeshlets(*culler);
+	else
+		drawRange(0, this->indexCount);
+	if (!vertexArrayBound)
+		glBindVertexArray(0);
+
+	unbindVertexFormat(shader);
+	unbindMaterial();
+}
+
+void Mesh::DrawDepth(Shader* shader, MeshletCuller* culler, bool vertexArrayBound)
+{
+	bindVertexFormat(shader);
+	if (!vertexArrayBound)
+		glBindVertexArray(this->arena ? this->arena->depthVertexArray() : this->depthVAO);
+	if (culler && !this->meshlets.empty())
+		drawMeshlets(*culler);
+	else
+		drawRange(0, this->indexCount);
+	if (!vertexArrayBound)
+		glBindVertexArray(0);
+	unbindVertexFormat(shader);
+}
+
+void Mesh::bindVertexFormat(Shader* shader) const
+{
+	// Tell the vertex shader how to decode the attributes
+	if (this->format == VERTEX_FORMAT_COMPACT)
+	{
+		shader->setInt(vertexFormatName, VERTEX_FORMAT_COMPACT);
+		shader->setVec3(positionOffsetName, positionOffset);
+		shader->setVec3(positionScaleName, positionScale);
+	}
+}
+
+void Mesh::unbindVertexFormat(Shader* shader) const
+{
+	// Other geometry drawn with this shader (e.g. the room cubes) uses plain floats
+	if (this->format == VERTEX_FORMAT_COMPACT)
+		shader->setInt(vertexFormatName, VERTEX_FORMAT_STANDARD);
+}
+
+void Mesh::bindMaterial(Shader* shader) const
 {
 	// Bind appropriate textures
 	GLuint diffuseNr = 1;
@@ -64,28 +225,42 @@ void Mesh::Draw(Shader* shader)
 	{
 		glActiveTexture(GL_TEXTURE0 + i); // Active proper texture unit before binding
 		// Retrieve texture number (the N in diffuse_textureN)
-		std::stringstream ss;
-		std::string number;
-		std::string name = this->textures[i].type;
-		if (name == "texture_diffuse")
-			ss << diffuseNr++; // Transfer GLuint to stream
-		else if (name == "texture_specular")
-			ss << specularNr++; // Transfer GLuint to stream
-		number = ss.str();
+		const std::string& type = this->textures[i].type;
+		Uniform<int> sampler;
+		if (type == "texture_diffuse")
+			sampler = shader->uniform<int>(samplerName(type, diffuseNr++));
+		else if (type == "texture_specular")
+			sampler = shader->uniform<int>(samplerName(type, specularNr++));
+		else
+			sampler = shader->uniform<int>(type);
 		// Now set the sampler to the correct texture unit
-		glUniform1i(glGetUniformLocation(shader->Program, (name + number).c_str()), i);
+		sampler.set((int)i);
 		// And finally bind the texture
 		glBindTexture(GL_TEXTURE_2D, this->textures[i].id);
 	}
 
 	// Also set each mesh's shininess property to a default value (if you want you could extend this to another mesh property and possibly change this value)
-	glUniform1f(glGetUniformLocation(shader->Program, "material.shininess"), 16.0f);
+	shader->setFloat(shininessName, 16.0f);
+}
 
-	// Draw mesh
-	glBindVertexArray(this->VAO);
-	glDrawElements(GL_TRIANGLES, this->indices.size(), GL_UNSIGNED_INT, 0);
-	glBindVertexArray(0);
+std::vector<unsigned int> Mesh::materialKey() const
+{
+	// Binding order decides which sampler a texture lands on, so it is part of the key
+	static const char* types[] = { "texture_diffuse", "texture_specular", "texture_normal", "texture_height" };
+	std::vector<unsigned int> key;
+	for (unsigned int i = 0; i < this->textures.size(); i++)
+	{
+		unsigned int type = 0;
+		while (type < 4 && this->textures[i].type != types[type])
+			type++;
+		key.push_back(this->textures[i].id);
+		key.push_back(type);
+	}
+	return key;
+}
 
+void Mesh::unbindMaterial() const
+{
 	// Always good practice to set everything back to defaults once configured.
 	for (GLuint i = 0; i < this->textures.size(); i++)
 	{
@@ -132,25 +307,140 @@ void Mesh::Draw(Shader* shader)
 //    glActiveTexture(GL_TEXTURE0);
 //}
 
+// Draws the accepted meshlets, neighbouring ones merged into a single glDrawElements range
+void Mesh::drawMeshlets(MeshletCuller& culler)
+{
+	unsigned int rangeStart = 0;
+	unsigned int rangeCount = 0;
+	for (unsigned int i = 0; i < this->meshlets.size(); i++)
+	{
+		const Meshlet& meshlet = this->meshlets[i];
+		if (!culler.visible(meshlet))
+			continue;
+		if (rangeCount > 0 && rangeStart + rangeCount == meshlet.firstIndex)
+		{
+			rangeCount += meshlet.indexCount;
+			continue;
+		}
+		if (rangeCount > 0)
+		{
+			drawRange(rangeStart, rangeCount);
+			culler.drawCalls++;
+		}
+		rangeStart = meshlet.firstIndex;
+		rangeCount = meshlet.indexCount;
+	}
+	if (rangeCount > 0)
+	{
+		drawRange(rangeStart, rangeCount);
+		culler.drawCalls++;
+	}
+}
+
+// Draws count indices starting at firstIndex of this mesh, the vertex array has to be bound
+void Mesh::drawRange(unsigned int firstIndex, unsigned int count)
+{
+	if (this->arena)
+	{
+		const MeshArena::Allocation& allocation = this->arena->allocation(this->arenaHandle);
+		glDrawElementsBaseVertex(GL_TRIANGLES, count, GL_UNSIGNED_INT, (void*)(size_t)((allocation.firstIndex + firstIndex) * sizeof(unsigned int)), allocation.baseVertex);
+		return;
+	}
+	unsigned int indexSize = this->indexType == GL_UNSIGNED_SHORT ? sizeof(unsigned short) : sizeof(unsigned int);
+	glDrawElements(GL_TRIANGLES, count, this->indexType, (void*)(size_t)(firstIndex * indexSize));
+}
+
 void Mesh::setUpMesh()
 {
+	setUpMesh(vertices.data(), vertices.size(), indices.data(), indices.size());
+}
+
+void Mesh::setUpMesh(const Vertex* vertexData, unsigned int vertexCount, const unsigned int* indexData, unsigned int indexCount)
+{
+	this->indexCount = indexCount;
+	boundsMin = boundsMax = vertexCount > 0 ? vertexData[0].Position : glm::vec3(0.0f);
+	for (unsigned int i = 1; i < vertexCount; i++)
+	{
+		boundsMin = glm::min(boundsMin, vertexData[i].Position);
+		boundsMax = glm::max(boundsMax, vertexData[i].Position);
+	}
+	boundsCenter = (boundsMin + boundsMax) * 0.5f;
+	float radiusSquared = 0.0f;
+	for (unsigned int i = 0; i < vertexCount; i++)
+	{
+		glm::vec3 offset = vertexData[i].Position - boundsCenter;
+		radiusSquared = std::max(radiusSquared, glm::dot(offset, offset));
+	}
+	boundsRadius = std::sqrt(radiusSquared);
+	positionOffset = glm::vec3(0.0f);
+	positionScale = glm::vec3(1.0f);
+	std::vector<CompactVertex> compact;
+	const void* uploadData = vertexData;
+	if (format == VERTEX_FORMAT_COMPACT)
+	{
+		compact = compactVertices(vertexData, vertexCount, positionOffset, positionScale);
+		uploadData = compact.data();
+	}
+	const VertexLayout& layout = VertexLayout::get(format);
+
+	// Arena meshes share the arena's buffers and VAO
+	if (arena)
+	{
+		VAO = VBO = EBO = 0;
+		depthVAO = positionVBO = 0;
+		indexType = GL_UNSIGNED_INT;
+		arenaHandle = arena->allocate(uploadData, vertexCount, indexData, indexCount);
+		return;
+	}
+
 	glGenVertexArrays(1, &VAO);
 	glBindVertexArray(VAO);
 
 	glGenBuffers(1, &VBO);
 	glBindBuffer(GL_ARRAY_BUFFER, VBO);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * vertices.size(), &vertices[0], GL_STATIC_DRAW);
+	glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)layout.stride * vertexCount, uploadData, GL_STATIC_DRAW);
 
+	// 16 bit indices halve the index buffer whenever every vertex is addressable with them
 	glGenBuffers(1, &EBO);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * indices.size(), &indices[0], GL_STATIC_DRAW);
-
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(3*sizeof(GL_FLOAT)));
-	glEnableVertexAttribArray(2);
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(6 * sizeof(GL_FLOAT)));
+	if (vertexCount < 65536)
+	{
+		indexType = GL_UNSIGNED_SHORT;
+		std::vector<unsigned short> shortIndices(indexData, indexData + indexCount);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned short) * indexCount, shortIndices.data(), GL_STATIC_DRAW);
+	}
+	else
+	{
+		indexType = GL_UNSIGNED_INT;
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * indexCount, indexData, GL_STATIC_DRAW);
+	}
+
+	for (unsigned int i = 0; i < layout.attributeCount; i++)
+	{
+		const VertexAttribute& attribute = layout.attributes[i];
+		glEnableVertexAttribArray(attribute.location);
+		glVertexAttribPointer(attribute.location, attribute.size, attribute.type, attribute.normalized, layout.stride, (void*)(size_t)attribute.offset);
+	}
+
+	// Positions again on their own, so depth passes don't stream normals and texture coordinates
+	const VertexLayout& positionLayout = VertexLayout::positions(format);
+	std::vector<unsigned char> positions((size_t)positionLayout.stride * vertexCount);
+	for (unsigned int i = 0; i < vertexCount; i++)
+	{
+		if (format == VERTEX_FORMAT_COMPACT)
+			memcpy(&positions[(size_t)i * positionLayout.stride], compact[i].Position, positionLayout.stride);
+		else
+			memcpy(&positions[(size_t)i * positionLayout.stride], &vertexData[i].Position, positionLayout.stride);
+	}
+	glGenVertexArrays(1, &depthVAO);
+	glBindVertexArray(depthVAO);
+	glGenBuffers(1, &positionVBO);
+	glBindBuffer(GL_ARRAY_BUFFER, positionVBO);
+	glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)positions.size(), positions.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+	const VertexAttribute& position = positionLayout.attributes[0];
+	glEnableVertexAttribArray(position.location);
+	glVertexAttribPointer(position.location, position.size, position.type, position.normalized, positionLayout.stride, (void*)(size_t)position.offset);
 
 	glBindVertexArray(0);
 }
@@ -11,6 +11,7 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include "Meshlet.h"
 #include "Shader.h"
 
 
@@ -23,6 +24,46 @@ struct Vertex {
     glm::vec2 TexCoords;
 };
 
+// GPU side layouts a Mesh can upload its vertices in, the CPU side always keeps full Vertex data
+enum VertexFormat {
+    // Vertex as is, 32 bytes
+    VERTEX_FORMAT_STANDARD = 0,
+    // CompactVertex, 16 bytes
+    VERTEX_FORMAT_COMPACT = 1
+};
+
+struct CompactVertex {
+    // unorm16 relative to the mesh AABB, w is padding
+    unsigned short Position[4];
+    // octahedral encoded unit normal, snorm16
+    short Normal[2];
+    // half floats, UVs of tiled materials go past 1
+    unsigned short TexCoords[2];
+};
+
+// One glVertexAttribPointer call
+struct VertexAttribute {
+    GLuint location;
+    GLint size;
+    GLenum type;
+    GLboolean normalized;
+    unsigned int offset;
+};
+
+// Attributes setUpMesh binds for a VertexFormat. The vertex shaders read the same locations and
+// decode them according to the vertexFormat uniform Mesh::Draw sets (see VertexShader.vs).
+struct VertexLayout {
+    unsigned int stride;
+    unsigned int attributeCount;
+    VertexAttribute attributes[3];
+
+    static const VertexLayout& get(VertexFormat format);
+    // Position alone, tightly packed: the stream of Mesh::DrawDepth
+    static const VertexLayout& positions(VertexFormat format);
+};
+
+class MeshArena;
+
 struct Texture {
     unsigned int id;
     std::string type;
@@ -35,19 +76,61 @@ class Mesh {
         std::vector<Vertex> vertices;
         std::vector<unsigned int> indices;
         std::vector<Texture> textures;
+        // Optional clusters of the index buffer for MeshletCuller (see Meshlet.h)
+        std::vector<Meshlet> meshlets;
+        // Object space AABB of the vertices, set on upload
+        glm::vec3 boundsMin;
+        glm::vec3 boundsMax;
+        // Object space bounding sphere around the AABB center, set on upload
+        glm::vec3 boundsCenter;
+        float boundsRadius;
 
         /*  Functions  */
         // Constructors
         // constructor provides all information in a float array
         Mesh(float vertices[]); 
         // constructor provides information in 3 vectors
-        Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<Texture> textures); 
+        // With an arena the mesh is suballocated from its buffers (and uses its format) instead of getting its own
+        Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<Texture> textures, VertexFormat format = VERTEX_FORMAT_STANDARD, MeshArena* arena = 0); 
+        // constructor uploads vertex/index spans owned by someone else (e.g. a mapped mesh cache)
+        // straight to the GPU, no CPU side copy is kept in vertices/indices
+        Mesh(const Vertex* vertices, unsigned int vertexCount, const unsigned int* indices, unsigned int indexCount, std::vector<Texture> textures, VertexFormat format = VERTEX_FORMAT_STANDARD, MeshArena* arena = 0);
         ~Mesh();
 
-        // Render the mesh
-        void Draw(Shader *shader);
+        // Render the mesh, with a culler only the meshlets it accepts are drawn.
+        // vertexArrayBound: the caller already bound the arena VAO (see Model::Draw)
+        void Draw(Shader *shader, MeshletCuller* culler = 0, bool vertexArrayBound = false);
+        // Render positions only, for depth and shadow passes: reads the position stream (12 of the 32
+        // bytes of a Vertex, 8 of a CompactVertex), binds no textures and sets no material uniforms.
+        // Arena meshes read the arena's packed position buffer (MeshArena::depthVertexArray).
+        void DrawDepth(Shader *shader, MeshletCuller* culler = 0, bool vertexArrayBound = false);
+        // Gives the space of an arena mesh back to its arena
+        void releaseArenaSpace();
+        // The textures and material uniforms Draw binds, for batched draws of meshes sharing them
+        void bindMaterial(Shader *shader) const;
+        void unbindMaterial() const;
+        // Texture ids in binding order, meshes with equal keys can share a bindMaterial
+        std::vector<unsigned int> materialKey() const;
 
     private:
+        friend class IndirectBatch;
         unsigned int VAO, VBO, EBO;
+        // Position stream of DrawDepth, sharing EBO
+        unsigned int depthVAO, positionVBO;
+        MeshArena* arena;
+        unsigned int arenaHandle;
+        unsigned int indexCount;
+        // GL_UNSIGNED_SHORT when every vertex fits, GL_UNSIGNED_INT otherwise
+        GLenum indexType;
+        VertexFormat format;
+        // Compact positions decode to positionOffset + position * positionScale (the mesh AABB)
+        glm::vec3 positionOffset;
+        glm::vec3 positionScale;
         void setUpMesh();
+        // Sets and resets the vertexFormat decoding uniforms of compact meshes
+        void bindVertexFormat(Shader *shader) const;
+        void unbindVertexFormat(Shader *shader) const;
+        void drawMeshlets(MeshletCuller& culler);
+        void drawRange(unsigned int firstIndex, unsigned int count);
+        void setUpMesh(const Vertex* vertexData, unsigned int vertexCount, const unsigned int* indexData, unsigned int indexCount);
 };
\ No newline at end of file
@@ -0,0 +1,380 @@
+#include "MeshCache.h"
+// Std. Includes
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+static_assert(sizeof(Vertex) == 8 * sizeof(float), "mesh cache stores Vertex as raw bytes");
+
+static const char MESH_CACHE_MAGIC[4] = { 'M', 'S', 'H', 'C' };
+
+static uint64_t alignTo16(uint64_t offset)
+{
+	return (offset + 15) & ~uint64_t(15);
+}
+
+// Hashes the whole content of a file, used when the mtime changed but the bytes may not have
+static bool hashFile(const std::string& path, uint64_t& hash)
+{
+	std::ifstream in(path.c_str(), std::ios::binary);
+	if (!in)
+		return false;
+	hash = MeshCache::hashBytes(0, 0);
+	std::vector<char> chunk(1 << 16);
+	while (in)
+	{
+		in.read(&chunk[0], chunk.size());
+		hash = MeshCache::hashBytes(&chunk[0], (size_t)in.gcount(), hash);
+	}
+	return true;
+}
+
+static bool statFile(const std::string& path, uint64_t& size, int64_t& mtime)
+{
+	struct stat info;
+	if (stat(path.c_str(), &info) != 0)
+		return false;
+	size = (uint64_t)info.st_size;
+	mtime = (int64_t)info.st_mtime;
+	return true;
+}
+
+// Moves a fully written temporary file over the cache file
+static bool replaceWithTempFile(const std::string& tempPath, const std::string& finalPath)
+{
+	std::remove(finalPath.c_str());
+	if (std::rename(tempPath.c_str(), finalPath.c_str()) != 0)
+	{
+		std::cout << "Mesh cache could not be written: " << finalPath << std::endl;
+		std::remove(tempPath.c_str());
+		return false;
+	}
+	return true;
+}
+
+MappedFile::MappedFile() : bytes(0), length(0)
+#ifdef _WIN32
+	, fileHandle(INVALID_HANDLE_VALUE), mappingHandle(0)
+#endif
+{
+}
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+bool MappedFile::open(const std::string& path)
+{
+	close();
+#ifdef _WIN32
+	fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+	if (fileHandle == INVALID_HANDLE_VALUE)
+		return false;
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0)
+	{
+		close();
+		return false;
+	}
+	mappingHandle = CreateFileMappingA(fileHandle, 0, PAGE_READONLY, 0, 0, 0);
+	if (!mappingHandle)
+	{
+		close();
+		return false;
+	}
+	bytes = (const unsigned char*)MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+	length = (size_t)fileSize.QuadPart;
+#else
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+	struct stat info;
+	if (fstat(fd, &info) != 0 || info.st_size == 0)
+	{
+		::close(fd);
+		return false;
+	}
+	void* view = mmap(0, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (view == MAP_FAILED)
+		return false;
+	bytes = (const unsigned char*)view;
+	length = (size_t)info.st_size;
+#endif
+	if (!bytes)
+	{
+		close();
+		return false;
+	}
+	return true;
+}
+
+void MappedFile::close()
+{
+#ifdef _WIN32
+	if (bytes)
+		UnmapViewOfFile(bytes);
+	if (mappingHandle)
+		CloseHandle(mappingHandle);
+	if (fileHandle != INVALID_HANDLE_VALUE)
+		CloseHandle(fileHandle);
+	mappingHandle = 0;
+	fileHandle = INVALID_HANDLE_VALUE;
+#else
+	if (bytes)
+		munmap((void*)bytes, length);
+#endif
+	bytes = 0;
+	length = 0;
+}
+
+MeshCache::MeshCache() : header(0), records(0), textureRecords(0), stringBlob(0)
+{
+}
+
+std::string MeshCache::cachePath(const std::string& sourcePath)
+{
+	return sourcePath + ".meshcache";
+}
+
+uint64_t MeshCache::hashBytes(const void* data, size_t size, uint64_t seed)
+{
+	const unsigned char* bytes = (const unsigned char*)data;
+	uint64_t hash = seed;
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+bool MeshCache::open(const std::string& sourcePath, unsigned int importFlags, uint64_t optionsKey)
+{
+	close();
+	uint64_t sourceSize;
+	int64_t sourceMtime;
+	if (!statFile(sourcePath, sourceSize, sourceMtime))
+		return false;
+	if (!file.open(cachePath(sourcePath)))
+		return false;
+
+	const unsigned char* base = file.data();
+	size_t size = file.size();
+	const MeshCacheHeader* candidate = (const MeshCacheHeader*)base;
+	if (size < sizeof(MeshCacheHeader)
+		|| std::memcmp(candidate->magic, MESH_CACHE_MAGIC, 4) != 0
+		|| candidate->version != MESH_CACHE_VERSION
+		|| candidate->importFlags != importFlags
+		|| candidate->optionsKey != optionsKey
+		|| candidate->pathHash != hashBytes(sourcePath.data(), sourcePath.size())
+		|| candidate->sourceSize != sourceSize)
+	{
+		close();
+		return false;
+	}
+	// A touched but unchanged source (checkout, copy) keeps its cache
+	if (candidate->sourceMtime != sourceMtime)
+	{
+		uint64_t contentHash;
+		if (!hashFile(sourcePath, contentHash) || contentHash != candidate->contentHash)
+		{
+			close();
+			return false;
+		}
+		// Store the new mtime so the next launch skips the hash. The mapping is released first,
+		// the cache file can't be replaced while it is mapped on Windows.
+		std::vector<unsigned char> patched(base, base + size);
+		((MeshCacheHeader*)&patched[0])->sourceMtime = sourceMtime;
+		close();
+		std::string finalPath = cachePath(sourcePath);
+		std::string tempPath = finalPath + ".tmp";
+		{
+			std::ofstream out(tempPath.c_str(), std::ios::binary | std::ios::trunc);
+			if (out)
+				out.write((const char*)&patched[0], patched.size());
+			bool written = (bool)out;
+			out.close();
+			if (written)
+				replaceWithTempFile(tempPath, finalPath);
+			else
+				std::remove(tempPath.c_str());
+		}
+		if (!file.open(finalPath) || file.size() != patched.size())
+		{
+			close();
+			return false;
+		}
+		base = file.data();
+		size = file.size();
+		candidate = (const MeshCacheHeader*)base;
+	}
+
+	uint64_t tablesEnd = sizeof(MeshCacheHeader)
+		+ (uint64_t)candidate->meshCount * sizeof(MeshCacheRecord)
+		+ (uint64_t)candidate->textureCount * sizeof(MeshCacheTexture)
+		+ candidate->stringBlobSize;
+	if (tablesEnd > size)
+	{
+		close();
+		return false;
+	}
+	header = candidate;
+	records = (const MeshCacheRecord*)(base + sizeof(MeshCacheHeader));
+	textureRecords = (const MeshCacheTexture*)(records + header->meshCount);
+	stringBlob = (const char*)(textureRecords + header->textureCount);
+
+	// Reject truncated files up front so mesh() never reads past the mapping
+	for (unsigned int i = 0; i < header->meshCount; i++)
+	{
+		const MeshCacheRecord& record = records[i];
+		if (record.vertexOffset + (uint64_t)record.vertexCount * sizeof(Vertex) > size
+			|| record.indexOffset + (uint64_t)record.indexCount * sizeof(unsigned int) > size
+			|| (uint64_t)record.firstTexture + record.textureCount > header->textureCount)
+		{
+			close();
+			return false;
+		}
+	}
+	for (unsigned int i = 0; i < header->textureCount; i++)
+	{
+		const MeshCacheTexture& texture = textureRecords[i];
+		if ((uint64_t)texture.typeOffset + texture.typeLength > header->stringBlobSize
+			|| (uint64_t)texture.pathOffset + texture.pathLength > header->stringBlobSize)
+		{
+			close();
+			return false;
+		}
+	}
+	return true;
+}
+
+void MeshCache::close()
+{
+	file.close();
+	header = 0;
+	records = 0;
+	textureRecords = 0;
+	stringBlob = 0;
+}
+
+unsigned int MeshCache::meshCount() const
+{
+	return header ? header->meshCount : 0;
+}
+
+MeshCache::MeshView MeshCache::mesh(unsigned int index) const
+{
+	const MeshCacheRecord& record = records[index];
+	MeshView view;
+	view.vertices = (const Vertex*)(file.data() + record.vertexOffset);
+	view.vertexCount = record.vertexCount;
+	view.indices = (const unsigned int*)(file.data() + record.indexOffset);
+	view.indexCount = record.indexCount;
+	view.trianglesOnly = (record.flags & MESH_CACHE_TRIANGLES_ONLY) != 0;
+	for (unsigned int i = 0; i < record.textureCount; i++)
+	{
+		const MeshCacheTexture& texture = textureRecords[record.firstTexture + i];
+		view.textures.push_back(std::make_pair(
+			std::string(stringBlob + texture.typeOffset, texture.typeLength),
+			std::string(stringBlob + texture.pathOffset, texture.pathLength)));
+	}
+	return view;
+}
+
+bool MeshCache::write(const std::string& sourcePath, unsigned int importFlags, uint64_t optionsKey, const std::vector<Mesh>& meshes, const std::vector<unsigned char>& trianglesOnly)
+{
+	MeshCacheHeader header;
+	std::memset(&header, 0, sizeof(header));
+	std::memcpy(header.magic, MESH_CACHE_MAGIC, 4);
+	header.version = MESH_CACHE_VERSION;
+	header.importFlags = importFlags;
+	header.optionsKey = optionsKey;
+	header.meshCount = (uint32_t)meshes.size();
+	header.pathHash = hashBytes(sourcePath.data(), sourcePath.size());
+	if (!statFile(sourcePath, header.sourceSize, header.sourceMtime) || !hashFile(sourcePath, header.contentHash))
+		return false;
+
+	std::vector<MeshCacheRecord> records(meshes.size());
+	std::vector<MeshCacheTexture> textures;
+	std::string stringBlob;
+	for (unsigned int i = 0; i < meshes.size(); i++)
+	{
+		records[i].vertexCount = (uint32_t)meshes[i].vertices.size();
+		records[i].indexCount = (uint32_t)meshes[i].indices.size();
+		records[i].firstTexture = (uint32_t)textures.size();
+		records[i].textureCount = (uint32_t)meshes[i].textures.size();
+		records[i].flags = trianglesOnly[i] ? MESH_CACHE_TRIANGLES_ONLY : 0;
+		for (unsigned int j = 0; j < meshes[i].textures.size(); j++)
+		{
+			MeshCacheTexture texture;
+			texture.typeOffset = (uint32_t)stringBlob.size();
+			texture.typeLength = (uint32_t)meshes[i].textures[j].type.size();
+			stringBlob += meshes[i].textures[j].type;
+			texture.pathOffset = (uint32_t)stringBlob.size();
+			texture.pathLength = (uint32_t)meshes[i].textures[j].path.size();
+			stringBlob += meshes[i].textures[j].path;
+			textures.push_back(texture);
+		}
+	}
+	header.textureCount = (uint32_t)textures.size();
+	header.stringBlobSize = (uint32_t)stringBlob.size();
+
+	// Lay the vertex and index spans out after the tables
+	uint64_t offset = sizeof(MeshCacheHeader) + records.size() * sizeof(MeshCacheRecord)
+		+ textures.size() * sizeof(MeshCacheTexture) + stringBlob.size();
+	for (unsigned int i = 0; i < records.size(); i++)
+	{
+		offset = alignTo16(offset);
+		records[i].vertexOffset = offset;
+		offset += (uint64_t)records[i].vertexCount * sizeof(Vertex);
+		offset = alignTo16(offset);
+		records[i].indexOffset = offset;
+		offset += (uint64_t)records[i].indexCount * sizeof(unsigned int);
+	}
+
+	// Write to a temporary file first so a crash never leaves a half written cache behind
+	std::string finalPath = cachePath(sourcePath);
+	std::string tempPath = finalPath + ".tmp";
+	{
+		std::ofstream out(tempPath.c_str(), std::ios::binary | std::ios::trunc);
+		if (!out)
+			return false;
+		out.write((const char*)&header, sizeof(header));
+		if (!records.empty())
+			out.write((const char*)&records[0], records.size() * sizeof(MeshCacheRecord));
+		if (!textures.empty())
+			out.write((const char*)&textures[0], textures.size() * sizeof(MeshCacheTexture));
+		out.write(stringBlob.data(), stringBlob.size());
+		static const char padding[16] = { 0 };
+		for (unsigned int i = 0; i < records.size(); i++)
+		{
+			out.write(padding, records[i].vertexOffset - (uint64_t)out.tellp());
+			out.write((const char*)meshes[i].vertices.data(), records[i].vertexCount * sizeof(Vertex));
+			out.write(padding, records[i].indexOffset - (uint64_t)out.tellp());
+			out.write((const char*)meshes[i].indices.data(), records[i].indexCount * sizeof(unsigned int));
+		}
+		if (!out)
+		{
+			out.close();
+			std::remove(tempPath.c_str());
+			return false;
+		}
+	}
+	return replaceWithTempFile(tempPath, finalPath);
+}
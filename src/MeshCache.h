@@ -0,0 +1,114 @@
+#pragma once
+// Std. Includes
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "Mesh.h"
+
+// Bump whenever the on-disk layout or what gets baked into it changes,
+// old cache files are then treated as stale and rebuilt from the source model.
+const uint32_t MESH_CACHE_VERSION = 4; // 2: meshes are stored optimized by MeshOptimizer, 3: welded by MeshWelder, 4: record flags
+
+// On-disk layout of a cache file:
+//   MeshCacheHeader
+//   MeshCacheRecord[meshCount]
+//   MeshCacheTexture[textureCount]
+//   string blob (texture types and paths, not null terminated)
+//   Vertex data, then index data of every mesh (16 byte aligned)
+struct MeshCacheHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t importFlags;
+    uint32_t meshCount;
+    uint32_t textureCount;
+    uint32_t stringBlobSize;
+    uint64_t pathHash;
+    uint64_t sourceSize;
+    int64_t sourceMtime;
+    uint64_t contentHash;
+    // hash of the Model import options (see ImportOptions)
+    uint64_t optionsKey;
+};
+
+// What the import knew about a mesh that its baked data doesn't show
+enum MeshCacheFlags {
+    // Every face was a triangle, so MeshOptimizer ran on it and it may be split into meshlets
+    MESH_CACHE_TRIANGLES_ONLY = 1
+};
+
+struct MeshCacheRecord {
+    uint64_t vertexOffset;
+    uint64_t indexOffset;
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    uint32_t firstTexture;
+    uint32_t textureCount;
+    // MeshCacheFlags
+    uint32_t flags;
+};
+
+struct MeshCacheTexture {
+    uint32_t typeOffset;
+    uint32_t typeLength;
+    uint32_t pathOffset;
+    uint32_t pathLength;
+};
+
+// Read only memory mapping of a whole file
+class MappedFile {
+    public:
+        MappedFile();
+        ~MappedFile();
+        bool open(const std::string& path);
+        void close();
+        const unsigned char* data() const { return bytes; }
+        size_t size() const { return length; }
+
+    private:
+        const unsigned char* bytes;
+        size_t length;
+#ifdef _WIN32
+        void* fileHandle;
+        void* mappingHandle;
+#endif
+        MappedFile(const MappedFile&);
+        MappedFile& operator=(const MappedFile&);
+};
+
+// Binary cache of the meshes Model builds out of an Assimp import. A cache file sits next to
+// the source model and is only used while the source path, its mtime (or content hash), the
+// import flags and the import options still match, so a warm start maps the file instead of running Assimp.
+class MeshCache {
+    public:
+        // Spans pointing into the mapped cache file, valid until close()
+        struct MeshView {
+            const Vertex* vertices;
+            unsigned int vertexCount;
+            const unsigned int* indices;
+            unsigned int indexCount;
+            bool trianglesOnly;
+            // type, path pairs as resolved by Model::loadMaterialTextures
+            std::vector<std::pair<std::string, std::string>> textures;
+        };
+
+        MeshCache();
+        // Maps the cache of sourcePath, returns false if there is none or it is stale
+        bool open(const std::string& sourcePath, unsigned int importFlags, uint64_t optionsKey);
+        void close();
+        unsigned int meshCount() const;
+        MeshView mesh(unsigned int index) const;
+
+        // Bakes the freshly imported meshes of sourcePath into its cache file, trianglesOnly has a flag per mesh
+        static bool write(const std::string& sourcePath, unsigned int importFlags, uint64_t optionsKey, const std::vector<Mesh>& meshes, const std::vector<unsigned char>& trianglesOnly);
+        static std::string cachePath(const std::string& sourcePath);
+        // 64 bit FNV-1a
+        static uint64_t hashBytes(const void* data, size_t size, uint64_t seed = 14695981039346656037ULL);
+
+    private:
+        MappedFile file;
+        const MeshCacheHeader* header;
+        const MeshCacheRecord* records;
+        const MeshCacheTexture* textureRecords;
+        const char* stringBlob;
+};
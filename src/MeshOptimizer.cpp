@@ -0,0 +1,220 @@
+#include "MeshOptimizer.h"
+// Std. Includes
+#include <vector>
+#include <algorithm>
+#include <climits>
+
+// GL Includes
+#include <glm/glm.hpp>
+
+MeshOptimizer::Stats MeshOptimizer::optimize(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices, float overdrawThreshold)
+{
+	Stats stats;
+	stats.triangles = (unsigned int)(indices.size() / 3);
+	stats.transformsBefore = countTransforms(indices, (unsigned int)vertices.size());
+
+	std::vector<unsigned int> clusters;
+	optimizeVertexCache(indices, (unsigned int)vertices.size(), &clusters);
+	optimizeOverdraw(indices, vertices, clusters, overdrawThreshold);
+	optimizeVertexFetch(vertices, indices);
+
+	// Unreferenced vertices are gone now, so ATVR before and after share the same denominator
+	stats.vertices = (unsigned int)vertices.size();
+	stats.transformsAfter = countTransforms(indices, (unsigned int)vertices.size());
+	return stats;
+}
+
+unsigned int MeshOptimizer::countTransforms(const std::vector<unsigned int>& indices, unsigned int vertexCount, unsigned int cacheSize)
+{
+	// FIFO cache: a vertex stays cached until cacheSize other vertices were transformed after it
+	std::vector<unsigned int> insertedAt(vertexCount, UINT_MAX);
+	unsigned int transforms = 0;
+	for (unsigned int i = 0; i < indices.size(); i++)
+	{
+		unsigned int v = indices[i];
+		if (insertedAt[v] == UINT_MAX || transforms - insertedAt[v] > cacheSize)
+		{
+			insertedAt[v] = transforms;
+			transforms++;
+		}
+	}
+	return transforms;
+}
+
+// Tipsify: fan around a vertex, then continue with the neighbour that is still cached and has few
+// triangles left, or skip to a recent vertex (dead end) when there is none. Every dead end starts a
+// new cluster, which optimizeOverdraw is free to move around.
+void MeshOptimizer::optimizeVertexCache(std::vector<unsigned int>& indices, unsigned int vertexCount, std::vector<unsigned int>* clusters)
+{
+	unsigned int triangleCount = (unsigned int)(indices.size() / 3);
+	if (clusters)
+		clusters->clear();
+	if (triangleCount == 0)
+		return;
+	const int cacheSize = (int)VERTEX_CACHE_SIZE;
+
+	// Vertex -> triangle adjacency
+	std::vector<unsigned int> live(vertexCount, 0);
+	for (unsigned int i = 0; i < indices.size(); i++)
+		live[indices[i]]++;
+	std::vector<unsigned int> offsets(vertexCount + 1, 0);
+	for (unsigned int v = 0; v < vertexCount; v++)
+		offsets[v + 1] = offsets[v] + live[v];
+	std::vector<unsigned int> adjacency(indices.size());
+	std::vector<unsigned int> filled(offsets.begin(), offsets.end() - 1);
+	for (unsigned int t = 0; t < triangleCount; t++)
+		for (unsigned int j = 0; j < 3; j++)
+			adjacency[filled[indices[t * 3 + j]]++] = t;
+
+	std::vector<int> cacheTime(vertexCount, 0);
+	std::vector<bool> emitted(triangleCount, false);
+	std::vector<unsigned int> deadEnds;
+	std::vector<unsigned int> candidates;
+	std::vector<unsigned int> output;
+	output.reserve(indices.size());
+	int time = cacheSize + 1;
+	unsigned int cursor = 0;
+	int fanning = 0;
+	if (clusters)
+		clusters->push_back(0);
+
+	while (fanning >= 0)
+	{
+		candidates.clear();
+		for (unsigned int a = offsets[fanning]; a < offsets[fanning + 1]; a++)
+		{
+			unsigned int t = adjacency[a];
+			if (emitted[t])
+				continue;
+			for (unsigned int j = 0; j < 3; j++)
+			{
+				unsigned int v = indices[t * 3 + j];
+				output.push_back(v);
+				deadEnds.push_back(v);
+				candidates.push_back(v);
+				live[v]--;
+				if (time - cacheTime[v] > cacheSize)
+					cacheTime[v] = time++;
+			}
+			emitted[t] = true;
+		}
+
+		// Next fanning vertex: the candidate that will still be in the cache after its remaining
+		// triangles are emitted and has been in there the longest
+		int best = -1;
+		int bestPriority = -1;
+		for (unsigned int c = 0; c < candidates.size(); c++)
+		{
+			unsigned int v = candidates[c];
+			if (live[v] == 0)
+				continue;
+			int priority = 0;
+			if (time - cacheTime[v] + 2 * (int)live[v] <= cacheSize)
+				priority = time - cacheTime[v];
+			if (priority > bestPriority)
+			{
+				bestPriority = priority;
+				best = (int)v;
+			}
+		}
+		if (best == -1)
+		{
+			// Dead end, fall back to the most recently emitted vertex with triangles left, then to the input order
+			while (!deadEnds.empty() && best == -1)
+			{
+				unsigned int v = deadEnds.back();
+				deadEnds.pop_back();
+				if (live[v] > 0)
+					best = (int)v;
+			}
+			while (best == -1 && cursor < vertexCount)
+			{
+				if (live[cursor] > 0)
+					best = (int)cursor;
+				cursor++;
+			}
+			if (best != -1 && clusters && clusters->back() != output.size() / 3)
+				clusters->push_back((unsigned int)(output.size() / 3));
+		}
+		fanning = best;
+	}
+	indices.swap(output);
+}
+
+// Orders clusters so the ones facing away from the mesh center (likely occluders) are drawn first
+void MeshOptimizer::optimizeOverdraw(std::vector<unsigned int>& indices, const std::vector<Vertex>& vertices, const std::vector<unsigned int>& clusters, float threshold)
+{
+	unsigned int triangleCount = (unsigned int)(indices.size() / 3);
+	if (clusters.size() < 2)
+		return;
+
+	std::vector<glm::vec3> centroids(clusters.size(), glm::vec3(0.0f));
+	std::vector<glm::vec3> normals(clusters.size(), glm::vec3(0.0f));
+	std::vector<float> areas(clusters.size(), 0.0f);
+	glm::vec3 meshCentroid(0.0f);
+	float meshArea = 0.0f;
+	for (unsigned int c = 0; c < clusters.size(); c++)
+	{
+		unsigned int end = c + 1 < clusters.size() ? clusters[c + 1] : triangleCount;
+		for (unsigned int t = clusters[c]; t < end; t++)
+		{
+			const glm::vec3& p0 = vertices[indices[t * 3 + 0]].Position;
+			const glm::vec3& p1 = vertices[indices[t * 3 + 1]].Position;
+			const glm::vec3& p2 = vertices[indices[t * 3 + 2]].Position;
+			glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+			float area = glm::length(normal);
+			centroids[c] += (p0 + p1 + p2) * (area / 3.0f);
+			normals[c] += normal;
+			areas[c] += area;
+		}
+		meshCentroid += centroids[c];
+		meshArea += areas[c];
+	}
+	if (meshArea <= 0.0f)
+		return;
+	meshCentroid /= meshArea;
+
+	std::vector<float> sortKeys(clusters.size(), 0.0f);
+	std::vector<unsigned int> order(clusters.size());
+	for (unsigned int c = 0; c < clusters.size(); c++)
+	{
+		order[c] = c;
+		float normalLength = glm::length(normals[c]);
+		if (areas[c] > 0.0f && normalLength > 0.0f)
+			sortKeys[c] = glm::dot(centroids[c] / areas[c] - meshCentroid, normals[c] / normalLength);
+	}
+	std::stable_sort(order.begin(), order.end(), [&sortKeys](unsigned int a, unsigned int b) { return sortKeys[a] > sortKeys[b]; });
+
+	std::vector<unsigned int> reordered;
+	reordered.reserve(indices.size());
+	for (unsigned int i = 0; i < order.size(); i++)
+	{
+		unsigned int c = order[i];
+		unsigned int end = c + 1 < clusters.size() ? clusters[c + 1] : triangleCount;
+		reordered.insert(reordered.end(), indices.begin() + clusters[c] * 3, indices.begin() + end * 3);
+	}
+
+	// Only worth it if the vertex cache doesn't suffer too much
+	unsigned int vertexCount = (unsigned int)vertices.size();
+	if (countTransforms(reordered, vertexCount) <= threshold * countTransforms(indices, vertexCount))
+		indices.swap(reordered);
+}
+
+// Puts vertices in the order the index buffer first references them and drops unreferenced ones
+void MeshOptimizer::optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+{
+	std::vector<unsigned int> remap(vertices.size(), UINT_MAX);
+	std::vector<Vertex> reordered;
+	reordered.reserve(vertices.size());
+	for (unsigned int i = 0; i < indices.size(); i++)
+	{
+		unsigned int v = indices[i];
+		if (remap[v] == UINT_MAX)
+		{
+			remap[v] = (unsigned int)reordered.size();
+			reordered.push_back(vertices[v]);
+		}
+		indices[i] = remap[v];
+	}
+	vertices.swap(reordered);
+}
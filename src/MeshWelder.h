@@ -0,0 +1,27 @@
+#pragma once
+// Std. Includes
+#include <vector>
+
+#include "Mesh.h"
+
+// Meshes with at least this many vertices are welded on several threads
+const unsigned int WELD_PARALLEL_THRESHOLD = 65536;
+
+// Import stage merge of duplicate vertices. Exporters (OBJ in particular) write one vertex per face
+// corner, so most vertices of a smooth mesh exist several times; welding them shrinks the vertex
+// buffer and lets the post-transform cache reuse them (run it before MeshOptimizer).
+// Two vertices are merged when position, normal and texture coordinates all fall into the same
+// epsilon sized grid cell, epsilon 0 merges bitwise identical vertices only.
+class MeshWelder {
+    public:
+        struct Stats {
+            unsigned int verticesBefore;
+            unsigned int verticesAfter;
+            unsigned int bytesBefore() const { return verticesBefore * (unsigned int)sizeof(Vertex); }
+            unsigned int bytesAfter() const { return verticesAfter * (unsigned int)sizeof(Vertex); }
+        };
+
+        // Drops duplicate vertices and rewrites indices to the first vertex of every group,
+        // the surviving vertices keep their relative order
+        static Stats weld(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices, float epsilon = 0.0f);
+};
@@ -0,0 +1,137 @@
+#include "Meshlet.h"
+// Std. Includes
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <climits>
+
+#include "Mesh.h"
+
+// Bounding sphere (around the AABB center) and normal cone of the triangles in [firstIndex, firstIndex + indexCount)
+static void computeMeshletBounds(Meshlet& meshlet, const Vertex* vertices, const unsigned int* indices)
+{
+	const unsigned int* begin = indices + meshlet.firstIndex;
+	glm::vec3 boundsMin = vertices[begin[0]].Position;
+	glm::vec3 boundsMax = boundsMin;
+	for (unsigned int i = 1; i < meshlet.indexCount; i++)
+	{
+		boundsMin = glm::min(boundsMin, vertices[begin[i]].Position);
+		boundsMax = glm::max(boundsMax, vertices[begin[i]].Position);
+	}
+	meshlet.center = (boundsMin + boundsMax) * 0.5f;
+	meshlet.radius = 0.0f;
+	for (unsigned int i = 0; i < meshlet.indexCount; i++)
+		meshlet.radius = std::max(meshlet.radius, glm::length(vertices[begin[i]].Position - meshlet.center));
+
+	// Geometric normals, so the cone agrees with the winding the rasterizer sees
+	std::vector<glm::vec3> normals;
+	normals.reserve(meshlet.indexCount / 3);
+	glm::vec3 axis(0.0f);
+	for (unsigned int t = 0; t + 2 < meshlet.indexCount; t += 3)
+	{
+		const glm::vec3& p0 = vertices[begin[t + 0]].Position;
+		const glm::vec3& p1 = vertices[begin[t + 1]].Position;
+		const glm::vec3& p2 = vertices[begin[t + 2]].Position;
+		glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+		float length = glm::length(normal);
+		if (length <= 0.0f)
+			continue;
+		normals.push_back(normal / length);
+		axis += normals.back();
+	}
+	meshlet.coneAxis = glm::vec3(0.0f, 0.0f, 1.0f);
+	meshlet.coneCutoff = 1.0f;
+	float axisLength = glm::length(axis);
+	if (normals.empty() || axisLength <= 0.0f)
+		return;
+	axis /= axisLength;
+	float minDot = 1.0f;
+	for (unsigned int i = 0; i < normals.size(); i++)
+		minDot = std::min(minDot, glm::dot(axis, normals[i]));
+	meshlet.coneAxis = axis;
+	// Faces spread over (almost) a hemisphere or more, some are always facing the camera
+	if (minDot <= 0.1f)
+		return;
+	meshlet.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+}
+
+std::vector<Meshlet> MeshletBuilder::build(const Vertex* vertices, unsigned int vertexCount, const unsigned int* indices, unsigned int indexCount)
+{
+	std::vector<Meshlet> meshlets;
+	// Vertex -> meshlet that last used it, to count the unique vertices of the open meshlet
+	std::vector<unsigned int> usedBy(vertexCount, UINT_MAX);
+	Meshlet current = Meshlet();
+	unsigned int currentVertices = 0;
+	for (unsigned int t = 0; t + 2 < indexCount; t += 3)
+	{
+		unsigned int newVertices = 0;
+		for (unsigned int j = 0; j < 3; j++)
+			newVertices += usedBy[indices[t + j]] != meshlets.size() ? 1 : 0;
+		if (current.indexCount > 0 && (currentVertices + newVertices > MESHLET_MAX_VERTICES || current.indexCount / 3 + 1 > MESHLET_MAX_TRIANGLES))
+		{
+			computeMeshletBounds(current, vertices, indices);
+			meshlets.push_back(current);
+			current = Meshlet();
+			current.firstIndex = t;
+			currentVertices = 0;
+		}
+		for (unsigned int j = 0; j < 3; j++)
+		{
+			if (usedBy[indices[t + j]] != meshlets.size())
+			{
+				usedBy[indices[t + j]] = (unsigned int)meshlets.size();
+				currentVertices++;
+			}
+		}
+		current.indexCount += 3;
+	}
+	if (current.indexCount > 0)
+	{
+		computeMeshletBounds(current, vertices, indices);
+		meshlets.push_back(current);
+	}
+	return meshlets;
+}
+
+MeshletCuller::MeshletCuller(const glm::mat4& model, const glm::mat4& viewProjection, const glm::vec3& cameraPosition)
+	: coneCulling(true), tested(0), frustumCulled(0), coneCulled(0), drawCalls(0)
+{
+	// Gribb/Hartmann: the planes of the clip matrix rows are the frustum in the space of its input,
+	// which is model space for projection * view * model
+	glm::mat4 clip = viewProjection * model;
+	for (int i = 0; i < 3; i++)
+	{
+		for (int side = 0; side < 2; side++)
+		{
+			glm::vec4 plane;
+			for (int column = 0; column < 4; column++)
+				plane[column] = clip[column][3] + (side == 0 ? clip[column][i] : -clip[column][i]);
+			float length = glm::length(glm::vec3(plane.x, plane.y, plane.z));
+			planes[i * 2 + side] = length > 0.0f ? plane / length : plane;
+		}
+	}
+	camera = glm::vec3(glm::inverse(model) * glm::vec4(cameraPosition, 1.0f));
+}
+
+bool MeshletCuller::visible(const Meshlet& meshlet)
+{
+	tested++;
+	for (int i = 0; i < 6; i++)
+	{
+		if (glm::dot(glm::vec3(planes[i]), meshlet.center) + planes[i].w < -meshlet.radius)
+		{
+			frustumCulled++;
+			return false;
+		}
+	}
+	if (coneCulling)
+	{
+		glm::vec3 toCenter = meshlet.center - camera;
+		if (glm::dot(toCenter, meshlet.coneAxis) > meshlet.coneCutoff * glm::length(toCenter) + meshlet.radius)
+		{
+			coneCulled++;
+			return false;
+		}
+	}
+	return true;
+}
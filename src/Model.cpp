@@ -6,6 +6,9 @@
 #include <iostream>
 #include <map>
 #include <vector>
+#include <chrono>
+#include <thread>
+#include <atomic>
 #include "stb_image.h"
 
 // GL Includes
@@ -18,60 +21,219 @@
 #include <assimp/postprocess.h>
 
 #include "Mesh.h"
+#include "MeshCache.h"
+#include "MeshWelder.h"
+#include "TextureLoader.h"
 #include "Shader.h"
 
-Model::Model(std::string path)
+// Post processing requested from Assimp, part of the mesh cache key
+static const unsigned int IMPORT_FLAGS = aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_CalcTangentSpace;
+
+// Hash of the options that change the baked meshes, the rest of the mesh cache key
+static uint64_t importOptionsKey(const ImportOptions& options)
+{
+	return MeshCache::hashBytes(&options.weldEpsilon, sizeof(options.weldEpsilon));
+}
+
+Model::Model(std::string path, bool useCache, const ImportOptions& options) : useCache(useCache), options(options)
 {
 	loadModel(path);
 }
 
 Model::~Model()
 {
+	for (unsigned int i = 0; i < meshes.size(); i++)
+		meshes[i].releaseArenaSpace();
 }
 
-void Model::Draw(Shader* shader)
+void Model::Draw(Shader* shader, MeshletCuller* culler, const unsigned char* visibleMeshes)
 {
+	// All meshes of an arena share one VAO, bind it once
+	if (options.arena)
+		glBindVertexArray(options.arena->vertexArray());
 	for (unsigned int i = 0; i < meshes.size(); i++)
 	{
-		meshes[i].Draw(shader);
+		if (visibleMeshes && !visibleMeshes[i])
+			continue;
+		meshes[i].Draw(shader, culler, options.arena != 0);
+	}
+	if (options.arena)
+		glBindVertexArray(0);
+}
+
+void Model::DrawDepth(Shader* shader, MeshletCuller* culler, const unsigned char* visibleMeshes)
+{
+	if (options.arena)
+		glBindVertexArray(options.arena->depthVertexArray());
+	for (unsigned int i = 0; i < meshes.size(); i++)
+	{
+		if (visibleMeshes && !visibleMeshes[i])
+			continue;
+		meshes[i].DrawDepth(shader, culler, options.arena != 0);
+	}
+	if (options.arena)
+		glBindVertexArray(0);
+}
+
+void Model::bounds(glm::vec3& boundsMin, glm::vec3& boundsMax) const
+{
+	boundsMin = boundsMax = glm::vec3(0.0f);
+	for (unsigned int i = 0; i < meshes.size(); i++)
+	{
+		boundsMin = i == 0 ? meshes[i].boundsMin : glm::min(boundsMin, meshes[i].boundsMin);
+		boundsMax = i == 0 ? meshes[i].boundsMax : glm::max(boundsMax, meshes[i].boundsMax);
 	}
 }
 
 void Model::loadModel(std::string path)
 {
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	directory = path.substr(0, path.find_last_of('\\'));
+	// Warm start: map the baked meshes and skip Assimp entirely
+	if (useCache && loadCachedModel(path))
+	{
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+		std::cout << "Loaded " << path << " from mesh cache in " << elapsed.count() << " ms" << std::endl;
+		return;
+	}
+
 	Assimp::Importer importer;
-	const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
+	const aiScene* scene = importer.ReadFile(path, IMPORT_FLAGS);
 	if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
 	{
 		std::cout << "Assimp Error" << importer.GetErrorString() << std::endl;
 		return;
 	}
-	directory = path.substr(0, path.find_last_of('\\'));
 	//std::cout << "success! " << directory << std::endl;
-	processNode(scene->mRootNode, scene);
+	std::vector<aiMesh*> sceneMeshes;
+	processNode(scene->mRootNode, scene, sceneMeshes);
+	std::vector<unsigned char> trianglesOnly;
+	processMeshes(sceneMeshes, scene, trianglesOnly);
+	if (useCache)
+		MeshCache::write(path, IMPORT_FLAGS, importOptionsKey(options), meshes, trianglesOnly);
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+	std::cout << "Loaded " << path << " with Assimp in " << elapsed.count() << " ms" << std::endl;
+}
+
+bool Model::loadCachedModel(const std::string& path)
+{
+	MeshCache cache;
+	if (!cache.open(path, IMPORT_FLAGS, importOptionsKey(options)))
+		return false;
+	meshes.reserve(cache.meshCount());
+	for (unsigned int i = 0; i < cache.meshCount(); i++)
+	{
+		MeshCache::MeshView view = cache.mesh(i);
+		std::vector<Texture> tempTextures;
+		for (unsigned int j = 0; j < view.textures.size(); j++)
+			tempTextures.push_back(loadMaterialTexture(view.textures[j].second, view.textures[j].first));
+		// The spans point into the mapping, setUpMesh uploads them without a CPU side copy
+		meshes.push_back(Mesh(view.vertices, view.vertexCount, view.indices, view.indexCount, tempTextures, vertexFormat(), options.arena));
+		// Same meshes as a cold import: only the optimized, triangle only ones
+		if (options.buildMeshlets && view.trianglesOnly)
+			meshes.back().meshlets = MeshletBuilder::build(view.vertices, view.vertexCount, view.indices, view.indexCount);
+		if (options.keepGeometry)
+		{
+			meshes.back().vertices.assign(view.vertices, view.vertices + view.vertexCount);
+			meshes.back().indices.assign(view.indices, view.indices + view.indexCount);
+		}
+	}
+	return true;
 }
 
-void Model::processNode(aiNode* node, const aiScene* scene)
+// Collects the meshes of the node tree in depth first order, which is the order they are drawn in
+void Model::processNode(aiNode* node, const aiScene* scene, std::vector<aiMesh*>& sceneMeshes)
 {
 	// std::cout << node->mName.data << std::endl; //print meshes contained in the model
 	for (unsigned int i = 0; i < node->mNumMeshes; i++)
 	{
-		aiMesh* curMesh = scene->mMeshes[node->mMeshes[i]];
-		/*std::vector<unsigned int>* tempIndices = new std::vector<unsigned int>;*/
-		meshes.push_back(processMesh(curMesh, scene));
-		/*tempIndices->~vector();*/
+		sceneMeshes.push_back(scene->mMeshes[node->mMeshes[i]]);
 	}
 	for (unsigned int i = 0; i < node->mNumChildren; i++) 
 	{
-		processNode(node->mChildren[i], scene);
+		processNode(node->mChildren[i], scene, sceneMeshes);
 	}
 }
 
-Mesh Model::processMesh(aiMesh* mesh, const aiScene* scene)
+// Converts all meshes on a pool of worker threads, meshes don't depend on each other.
+// Only texture loading and Mesh::setUpMesh touch GL, so they run afterwards on this (the context) thread, in order.
+void Model::processMeshes(const std::vector<aiMesh*>& sceneMeshes, const aiScene* scene, std::vector<unsigned char>& trianglesOnly)
 {
-	std::vector<Vertex> tempVertices;
-	std::vector<unsigned int> tempIndices;
-	std::vector<Texture> tempTextures;
+	std::vector<MeshData> results(sceneMeshes.size());
+	std::atomic<unsigned int> nextMesh(0);
+	unsigned int workerCount = std::thread::hardware_concurrency();
+	if (workerCount == 0)
+		workerCount = 1;
+	if (workerCount > sceneMeshes.size())
+		workerCount = (unsigned int)sceneMeshes.size();
+
+	std::vector<std::thread> workers;
+	for (unsigned int w = 1; w < workerCount; w++)
+	{
+		workers.push_back(std::thread([&]() {
+			for (unsigned int i = nextMesh++; i < sceneMeshes.size(); i = nextMesh++)
+				processMesh(sceneMeshes[i], scene, results[i]);
+		}));
+	}
+	// The calling thread works too instead of just waiting
+	for (unsigned int i = nextMesh++; i < sceneMeshes.size(); i = nextMesh++)
+		processMesh(sceneMeshes[i], scene, results[i]);
+	for (unsigned int w = 0; w < workers.size(); w++)
+		workers[w].join();
+
+	// Report what welding saved per mesh and in total
+	MeshWelder::Stats welded = MeshWelder::Stats();
+	for (unsigned int i = 0; i < results.size(); i++)
+	{
+		const MeshWelder::Stats& stats = results[i].weldStats;
+		welded.verticesBefore += stats.verticesBefore;
+		welded.verticesAfter += stats.verticesAfter;
+		if (stats.verticesAfter < stats.verticesBefore)
+		{
+			std::cout << "Welded mesh " << i << ": " << stats.verticesBefore << " -> " << stats.verticesAfter << " vertices ("
+				<< stats.bytesBefore() << " -> " << stats.bytesAfter() << " bytes)" << std::endl;
+		}
+	}
+	if (welded.verticesAfter < welded.verticesBefore)
+	{
+		std::cout << "Welded " << welded.verticesBefore << " -> " << welded.verticesAfter << " vertices, "
+			<< (welded.bytesBefore() - welded.bytesAfter()) / 1024 << " KB saved" << std::endl;
+	}
+
+	// Report what the import stage optimizer saved in vertex shader work
+	MeshOptimizer::Stats total = MeshOptimizer::Stats();
+	for (unsigned int i = 0; i < results.size(); i++)
+	{
+		if (!results[i].optimized)
+			continue;
+		total.triangles += results[i].stats.triangles;
+		total.vertices += results[i].stats.vertices;
+		total.transformsBefore += results[i].stats.transformsBefore;
+		total.transformsAfter += results[i].stats.transformsAfter;
+	}
+	if (total.triangles > 0)
+	{
+		std::cout << "Optimized " << total.triangles << " triangles: ACMR " << total.acmrBefore() << " -> " << total.acmrAfter()
+			<< ", ATVR " << total.atvrBefore() << " -> " << total.atvrAfter() << std::endl;
+	}
+
+	meshes.reserve(meshes.size() + results.size());
+	for (unsigned int i = 0; i < results.size(); i++)
+	{
+		std::vector<Texture> tempTextures;
+		for (unsigned int j = 0; j < results[i].textures.size(); j++)
+			tempTextures.push_back(loadMaterialTexture(results[i].textures[j].second, results[i].textures[j].first));
+		meshes.push_back(Mesh(std::move(results[i].vertices), std::move(results[i].indices), tempTextures, vertexFormat(), options.arena));
+		meshes.back().meshlets.swap(results[i].meshlets);
+		trianglesOnly.push_back(results[i].optimized);
+	}
+}
+
+void Model::processMesh(aiMesh* mesh, const aiScene* scene, MeshData& data) const
+{
+	std::vector<Vertex>& tempVertices = data.vertices;
+	std::vector<unsigned int>& tempIndices = data.indices;
+	tempVertices.reserve(mesh->mNumVertices);
 
 	for (unsigned int i = 0; i < mesh->mNumVertices; i++)
 	{
@@ -102,128 +264,64 @@ Mesh Model::processMesh(aiMesh* mesh, const aiScene* scene)
 		aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
 
 		// 1. Diffuse maps
-		std::vector<Texture> diffuseMaps = this->loadMaterialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse");
-		tempTextures.insert(tempTextures.end(), diffuseMaps.begin(), diffuseMaps.end());
+		collectMaterialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse", data);
 		// 2. Specular maps
-		std::vector<Texture> specularMaps = this->loadMaterialTextures(material, aiTextureType_SPECULAR, "texture_specular");
-		tempTextures.insert(tempTextures.end(), specularMaps.begin(), specularMaps.end());
+		collectMaterialTextures(material, aiTextureType_SPECULAR, "texture_specular", data);
 		// 3. normal maps
-		std::vector<Texture> normalMaps = loadMaterialTextures(material, aiTextureType_HEIGHT, "texture_normal");
-		tempTextures.insert(tempTextures.end(), normalMaps.begin(), normalMaps.end());
+		collectMaterialTextures(material, aiTextureType_HEIGHT, "texture_normal", data);
 		// 4. height maps
-		std::vector<Texture> heightMaps = loadMaterialTextures(material, aiTextureType_AMBIENT, "texture_height");
-		tempTextures.insert(tempTextures.end(), heightMaps.begin(), heightMaps.end());
+		collectMaterialTextures(material, aiTextureType_AMBIENT, "texture_height", data);
 	}
 
-	//std::cout << (mesh->mNumFaces) * (mesh->mFaces[0].mNumIndices) << std::endl;
-	//tempIndices.reserve((mesh->mNumFaces) * (mesh->mFaces[0].mNumIndices));
-
+	// Faces are triangles after aiProcess_Triangulate, apart from point and line primitives
+	bool trianglesOnly = true;
+	tempIndices.reserve(mesh->mNumFaces * 3);
 	for (unsigned int i = 0; i < mesh->mNumFaces; i++)
 	{
+		trianglesOnly = trianglesOnly && mesh->mFaces[i].mNumIndices == 3;
 		for (unsigned int j = 0; j < mesh->mFaces[i].mNumIndices; j++)
 		{
 			tempIndices.push_back(mesh->mFaces[i].mIndices[j]);
 		}
 	}
 
-	return Mesh(tempVertices, tempIndices, tempTextures);
+	// Merge the vertices the exporter duplicated per face corner, before the optimizer counts cache hits
+	data.weldStats.verticesBefore = (unsigned int)tempVertices.size();
+	data.weldStats.verticesAfter = (unsigned int)tempVertices.size();
+	if (options.weldEpsilon >= 0.0f)
+		data.weldStats = MeshWelder::weld(tempVertices, tempIndices, options.weldEpsilon);
+
+	// Reorder for the vertex cache, overdraw and vertex fetch before anything is uploaded (or cached)
+	data.optimized = trianglesOnly;
+	if (data.optimized)
+		data.stats = MeshOptimizer::optimize(tempVertices, tempIndices);
+	// Meshlets follow the final index order
+	if (options.buildMeshlets && data.optimized)
+		data.meshlets = MeshletBuilder::build(tempVertices.data(), (unsigned int)tempVertices.size(), tempIndices.data(), (unsigned int)tempIndices.size());
 }
-Mesh Model::processMesh(aiMesh* mesh, const aiScene* scene, std::vector<unsigned int>* tempIndices)
-{
-	std::vector<Vertex> tempVertices;
-	std::vector<Texture> tempTextures;
-
-	for (unsigned int i = 0; i < mesh->mNumVertices; i++)
-	{
-		Vertex tempVertex;
-
-		tempVertex.Position.x = mesh->mVertices[i].x;
-		tempVertex.Position.y = mesh->mVertices[i].y;
-		tempVertex.Position.z = mesh->mVertices[i].z;
-
-		tempVertex.Normal.x = mesh->mNormals[i].x;
-		tempVertex.Normal.y = mesh->mNormals[i].y;
-		tempVertex.Normal.z = mesh->mNormals[i].z;
 
-		if (mesh->mTextureCoords[0])
-		{
-			tempVertex.TexCoords.x = mesh->mTextureCoords[0][i].x;
-			tempVertex.TexCoords.y = mesh->mTextureCoords[0][i].y;
-		}
-		else
-		{
-			tempVertex.TexCoords = glm::vec2(0.0f, 0.0f);
-		}
-		tempVertices.push_back(tempVertex);
-
-		/*for (unsigned int i = 0; i < mesh->mNumFaces; i++)
-		{
-			for (unsigned int j = 0; j < mesh->mFaces[i].mNumIndices; j++)
-			{
-				tempIndices->push_back(mesh->mFaces[i].mIndices[j]);
-			}
-		}*/
-		for (unsigned int i = 0; i < mesh->mNumFaces; i++)
-		{
-			aiFace face = mesh->mFaces[i];
-			// retrieve all indices of the face and store them in the indices vector
-			for (unsigned int j = 0; j < face.mNumIndices; j++)
-				tempIndices->push_back(face.mIndices[j]);
-		}
-
-		if (mesh->mMaterialIndex >= 0)
-		{
-			aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
-
-			// 1. Diffuse maps
-			std::vector<Texture> diffuseMaps = this->loadMaterialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse");
-			tempTextures.insert(tempTextures.end(), diffuseMaps.begin(), diffuseMaps.end());
-			// 2. Specular maps
-			std::vector<Texture> specularMaps = this->loadMaterialTextures(material, aiTextureType_SPECULAR, "texture_specular");
-			tempTextures.insert(tempTextures.end(), specularMaps.begin(), specularMaps.end());
-			// 3. normal maps
-			std::vector<Texture> normalMaps = loadMaterialTextures(material, aiTextureType_HEIGHT, "texture_normal");
-			tempTextures.insert(tempTextures.end(), normalMaps.begin(), normalMaps.end());
-			// 4. height maps
-			std::vector<Texture> heightMaps = loadMaterialTextures(material, aiTextureType_AMBIENT, "texture_height");
-			tempTextures.insert(tempTextures.end(), heightMaps.begin(), heightMaps.end());
-		}
-	}
-
-	return Mesh(tempVertices, *tempIndices, tempTextures);
-}
-
-// Checks all material textures of a given type and loads the textures if they're not loaded yet.
-	// The required info is returned as a Texture struct.
-std::vector<Texture> Model::loadMaterialTextures(aiMaterial* mat, aiTextureType type, std::string typeName)
+// Collects the paths of all material textures of a given type, they're loaded later by loadMaterialTexture.
+void Model::collectMaterialTextures(aiMaterial* mat, aiTextureType type, std::string typeName, MeshData& data) const
 {
-	std::vector<Texture> textures;
 	for (GLuint i = 0; i < mat->GetTextureCount(type); i++)
 	{
 		aiString str;
 		mat->GetTexture(type, i, &str);
-		// Check if texture was loaded before and if so, continue to next iteration: skip loading a new texture
-		GLboolean skip = false;
-		for (GLuint j = 0; j < textures_loaded.size(); j++)
-		{
-			if (std::strcmp(textures_loaded[j].path.data(), str.C_Str()) == 0)
-			{
-				textures.push_back(textures_loaded[j]);
-				skip = true; // A texture with the same filepath has already been loaded, continue to next one. (optimization)
-				break;
-			}
-		}
-		if (!skip)
-		{   // If texture hasn't been loaded already, load it
-			Texture texture;
-			texture.id = TextureFromFile1(str.C_Str(), this->directory);
-			texture.type = typeName;
-			texture.path = str.C_Str();
-			textures.push_back(texture);
-			this->textures_loaded.push_back(texture);  // Store it as texture loaded for entire model, to ensure we won't unnecesery load duplicate textures.
-		}
+		data.textures.push_back(std::make_pair(typeName, std::string(str.C_Str())));
 	}
-	return textures;
+}
+
+// Loads a single material texture. The registry shares textures between all models and
+// skips loading an image that is already loaded under the same path (or the same content).
+Texture Model::loadMaterialTexture(const std::string& path, const std::string& typeName)
+{
+	TextureHandle handle = TextureRegistry::instance().acquire(this->directory + '\\' + path);
+	this->textures_loaded.push_back(handle);  // Keeps the texture alive for as long as this model
+	Texture texture;
+	texture.id = handle.id();
+	texture.type = typeName;
+	texture.path = path;
+	return texture;
 }
 
 
@@ -259,37 +357,6 @@ unsigned int Model::TextureFromFile1(const char* path, const std::string& direct
 	filename = directory + '\\' + filename;
 	std::cout << filename << std::endl;
 
-	unsigned int textureID;
-	glGenTextures(1, &textureID);
-
-	int width, height, nrComponents;
-	unsigned char* data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
-	if (data)
-	{
-		GLenum format;
-		if (nrComponents == 1)
-			format = GL_RED;
-		else if (nrComponents == 3)
-			format = GL_RGB;
-		else if (nrComponents == 4)
-			format = GL_RGBA;
-
-		glBindTexture(GL_TEXTURE_2D, textureID);
-		glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-		glGenerateMipmap(GL_TEXTURE_2D);
-
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-		stbi_image_free(data);
-	}
-	else
-	{
-		std::cout << "Texture failed to load at path: " << path << std::endl;
-		stbi_image_free(data);
-	}
-
-	return textureID;
+	// Decoded on a background thread, the id can be used right away and shows a placeholder until the upload lands
+	return TextureLoader::instance().load(filename);
 }
\ No newline at end of file
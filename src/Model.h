@@ -8,24 +8,72 @@
 #include <assimp/postprocess.h>
 
 #include "Mesh.h"
+#include "MeshArena.h"
+#include "MeshOptimizer.h"
+#include "MeshWelder.h"
 #include "Shader.h"
+#include "TextureRegistry.h"
+
+// Settings of the import stage. The ones that change the baked meshes are part of the mesh cache key.
+struct ImportOptions {
+	// Weld grid size for MeshWelder, 0 merges identical vertices only, negative disables welding
+	float weldEpsilon;
+	// Upload as CompactVertex (half the vertex memory), only affects the GPU copy so the cache is shared
+	bool compactVertices;
+	// Split meshes into meshlets for Draw with a MeshletCuller, built on load so the cache is shared too
+	bool buildMeshlets;
+	// Suballocate all meshes from this arena (its format wins over compactVertices), e.g. one arena shared
+	// by every model of a scene; 0 gives every mesh its own VAO/VBO/EBO
+	MeshArena* arena;
+	// Keep vertices/indices on the CPU for cached loads too (Assimp loads always keep them), for
+	// triangle picking with SceneBVH; doesn't change the baked meshes
+	bool keepGeometry;
+	ImportOptions() : weldEpsilon(0.0f), compactVertices(false), buildMeshlets(false), arena(0), keepGeometry(false) {}
+};
 
 class Model
 {
 	public:
-		Model(std::string path);
+		// useCache: reuse/bake the binary mesh cache next to the source model (see MeshCache.h)
+		Model(std::string path, bool useCache = true, const ImportOptions& options = ImportOptions());
 		~Model();
 		std::vector<Mesh> meshes;
 		std::string directory;
-		void Draw(Shader* shader);
+		// visibleMeshes: one flag per mesh, meshes flagged 0 are skipped (see FrustumCuller)
+		void Draw(Shader* shader, MeshletCuller* culler = 0, const unsigned char* visibleMeshes = 0);
+		// Positions only, see Mesh::DrawDepth
+		void DrawDepth(Shader* shader, MeshletCuller* culler = 0, const unsigned char* visibleMeshes = 0);
+		// Object space AABB of all meshes
+		void bounds(glm::vec3& boundsMin, glm::vec3& boundsMax) const;
 	private:
+		// ~Model gives the meshes' arena space back, a copy would free it twice
+		Model(const Model&);
+		Model& operator=(const Model&);
 		//std::string directory;
-		std::vector<Texture> textures_loaded;
+		// References to the shared textures this model uses, see TextureRegistry
+		std::vector<TextureHandle> textures_loaded;
+		bool useCache;
+		ImportOptions options;
 		void loadModel(std::string path);
-		void processNode(aiNode* node, const aiScene* scene);
-		Mesh processMesh(aiMesh* mesh, const aiScene* scene);
-		Mesh processMesh(aiMesh* mesh, const aiScene* scene, std::vector<unsigned int>* tempIndices);
-		std::vector<Texture> loadMaterialTextures(aiMaterial* mat, aiTextureType type, std::string typeName);
+		bool loadCachedModel(const std::string& path);
+		VertexFormat vertexFormat() const { return options.compactVertices ? VERTEX_FORMAT_COMPACT : VERTEX_FORMAT_STANDARD; }
+		// CPU side result of converting one aiMesh, built on a worker thread before any GL object exists
+		struct MeshData {
+			std::vector<Vertex> vertices;
+			std::vector<unsigned int> indices;
+			// type, path pairs of the material textures, loaded later on the context thread
+			std::vector<std::pair<std::string, std::string>> textures;
+			MeshWelder::Stats weldStats;
+			bool optimized;
+			MeshOptimizer::Stats stats;
+			std::vector<Meshlet> meshlets;
+		};
+		void processNode(aiNode* node, const aiScene* scene, std::vector<aiMesh*>& sceneMeshes);
+		// trianglesOnly gets a flag per mesh, for the mesh cache
+		void processMeshes(const std::vector<aiMesh*>& sceneMeshes, const aiScene* scene, std::vector<unsigned char>& trianglesOnly);
+		void processMesh(aiMesh* mesh, const aiScene* scene, MeshData& data) const;
+		void collectMaterialTextures(aiMaterial* mat, aiTextureType type, std::string typeName, MeshData& data) const;
+		Texture loadMaterialTexture(const std::string& path, const std::string& typeName);
 		GLint TextureFromFile(const char* path, std::string directory);
 		unsigned int TextureFromFile1(const char* path, const std::string& directory);
 };
\ No newline at end of file
@@ -9,10 +9,15 @@
 
 #include <glad/glad.h>
 
+#include "UniformTable.h"
+#include "UniformBlocks.h"
+
 class Shader
 {
 public:
     GLuint Program;
+    // Locations of the program's active uniforms, reflected once after linking
+    UniformTable uniforms;
     enum Slot
     {
         DIFFUSE,
@@ -90,6 +95,8 @@ public:
             glGetProgramInfoLog(this->Program, 512, NULL, infoLog);
             std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
         }
+        this->uniforms.reflect(this->Program);
+        bindUniformBlocks(this->Program);
         // Delete the shaders as they're linked into our program now and no longer necessery
         glDeleteShader(vertex);
         glDeleteShader(fragment);
@@ -100,6 +107,30 @@ public:
     {
         glUseProgram(this->Program);
     }
+
+    // Typed handle of a uniform, for loops that set it over and over
+    template <typename T>
+    Uniform<T> uniform(const std::string& name) const
+    {
+        return this->uniforms.get<T>(name);
+    }
+    // Setters skip the upload when the value didn't change since the last one, the program has to be in use
+    void setInt(const std::string& name, int value) const
+    {
+        this->uniforms.get<int>(name).set(value);
+    }
+    void setFloat(const std::string& name, float value) const
+    {
+        this->uniforms.get<float>(name).set(value);
+    }
+    void setVec3(const std::string& name, const glm::vec3& value) const
+    {
+        this->uniforms.get<glm::vec3>(name).set(value);
+    }
+    void setMat4(const std::string& name, const glm::mat4& value) const
+    {
+        this->uniforms.get<glm::mat4>(name).set(value);
+    }
 };
 
 #endif
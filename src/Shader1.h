@@ -9,6 +9,9 @@
 #include <sstream>
 #include <iostream>
 
+#include "UniformTable.h"
+#include "UniformBlocks.h"
+
 class Shader
 {
 public:
@@ -65,6 +68,10 @@ public:
         glAttachShader(ID, fragment);
         glLinkProgram(ID);
         checkCompileErrors(ID, "PROGRAM");
+        // look every uniform location up once, the setters only hit the table afterwards
+        uniforms.reflect(ID);
+        // shared blocks (camera constants, ...) sit at fixed binding points
+        bindUniformBlocks(ID);
         // delete the shaders as they're linked into our program now and no longer necessery
         glDeleteShader(vertex);
         glDeleteShader(fragment);
@@ -76,66 +83,80 @@ public:
     {
         glUseProgram(ID);
     }
-    // utility uniform functions
+    // typed handle for hot loops, set() skips even the name lookup
+    // ------------------------------------------------------------------------
+    template <typename T>
+    Uniform<T> uniform(const std::string& name) const
+    {
+        return uniforms.get<T>(name);
+    }
+    // uploads issued and skipped since the last resetUniformCounters()
+    // ------------------------------------------------------------------------
+    unsigned int uniformUploads() const { return uniforms.uploadsIssued; }
+    unsigned int uniformUploadsSkipped() const { return uniforms.uploadsSkipped; }
+    void resetUniformCounters() { uniforms.resetCounters(); }
+    // utility uniform functions, values equal to the last upload are skipped (see UniformTable)
     // ------------------------------------------------------------------------
     void setBool(const std::string& name, bool value) const
     {
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+        uniforms.get<bool>(name).set(value);
     }
     // ------------------------------------------------------------------------
     void setInt(const std::string& name, int value) const
     {
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+        uniforms.get<int>(name).set(value);
     }
     // ------------------------------------------------------------------------
     void setFloat(const std::string& name, float value) const
     {
-        glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+        uniforms.get<float>(name).set(value);
     }
     // ------------------------------------------------------------------------
     void setVec2(const std::string& name, const glm::vec2& value) const
     {
-        glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+        uniforms.get<glm::vec2>(name).set(value);
     }
     void setVec2(const std::string& name, float x, float y) const
     {
-        glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y);
+        uniforms.get<glm::vec2>(name).set(glm::vec2(x, y));
     }
     // ------------------------------------------------------------------------
     void setVec3(const std::string& name, const glm::vec3& value) const
     {
-        glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+        uniforms.get<glm::vec3>(name).set(value);
     }
     void setVec3(const std::string& name, float x, float y, float z) const
     {
-        glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z);
+        uniforms.get<glm::vec3>(name).set(glm::vec3(x, y, z));
     }
     // ------------------------------------------------------------------------
     void setVec4(const std::string& name, const glm::vec4& value) const
     {
-        glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+        uniforms.get<glm::vec4>(name).set(value);
     }
     void setVec4(const std::string& name, float x, float y, float z, float w) const
     {
-        glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w);
+        uniforms.get<glm::vec4>(name).set(glm::vec4(x, y, z, w));
     }
     // ------------------------------------------------------------------------
     void setMat2(const std::string& name, const glm::mat2& mat) const
     {
-        glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        uniforms.get<glm::mat2>(name).set(mat);
     }
     // ------------------------------------------------------------------------
     void setMat3(const std::string& name, const glm::mat3& mat) const
     {
-        glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        uniforms.get<glm::mat3>(name).set(mat);
     }
     // ------------------------------------------------------------------------
     void setMat4(const std::string& name, const glm::mat4& mat) const
     {
-        glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        uniforms.get<glm::mat4>(name).set(mat);
     }
 
 private:
+    UniformTable uniforms;
+
     // utility function for checking shader compilation/linking errors.
     // ------------------------------------------------------------------------
     void checkCompileErrors(GLuint shader, std::string type)
@@ -162,4 +183,4 @@ private:
         }
     }
 };
-#endif
\ No newline at end of file
+#endif
\ No newline at end of file
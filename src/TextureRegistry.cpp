@@ -0,0 +1,115 @@
+#include "TextureRegistry.h"
+// Std. Includes
+#include <string>
+#include <fstream>
+#include <vector>
+
+// GL Includes
+#include <glad/glad.h>
+
+#include "MeshCache.h"
+#include "TextureLoader.h"
+
+TextureHandle::TextureHandle() : entry(0)
+{
+}
+
+TextureHandle::TextureHandle(TextureEntry* entry) : entry(entry)
+{
+	entry->references++;
+}
+
+TextureHandle::TextureHandle(const TextureHandle& other) : entry(other.entry)
+{
+	if (entry)
+		entry->references++;
+}
+
+TextureHandle& TextureHandle::operator=(const TextureHandle& other)
+{
+	if (other.entry)
+		other.entry->references++;
+	if (entry)
+		TextureRegistry::instance().release(entry);
+	entry = other.entry;
+	return *this;
+}
+
+TextureHandle::~TextureHandle()
+{
+	if (entry)
+		TextureRegistry::instance().release(entry);
+}
+
+TextureRegistry& TextureRegistry::instance()
+{
+	static TextureRegistry registry;
+	return registry;
+}
+
+TextureRegistry::TextureRegistry() : contentDedupe(false), liveTextures(0), pathHits(0), contentHits(0), misses(0)
+{
+}
+
+TextureHandle TextureRegistry::acquire(const std::string& path, bool clampAlphaEdges)
+{
+	// Same image with different wrap modes needs two texture objects
+	std::string key = clampAlphaEdges ? path + "|clamp" : path;
+	std::unordered_map<std::string, TextureEntry*>::iterator found = byPath.find(key);
+	if (found != byPath.end())
+	{
+		pathHits++;
+		return TextureHandle(found->second);
+	}
+
+	uint64_t contentHash = 0;
+	bool hasContentHash = false;
+	if (contentDedupe)
+	{
+		std::ifstream in(path.c_str(), std::ios::binary);
+		if (in)
+		{
+			std::vector<char> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+			contentHash = MeshCache::hashBytes(bytes.data(), bytes.size());
+			contentHash = MeshCache::hashBytes(&clampAlphaEdges, sizeof(clampAlphaEdges), contentHash);
+			hasContentHash = true;
+			std::unordered_map<uint64_t, TextureEntry*>::iterator same = byContent.find(contentHash);
+			if (same != byContent.end())
+			{
+				// Known image under a new name, remember the alias
+				contentHits++;
+				same->second->pathKeys.push_back(key);
+				byPath[key] = same->second;
+				return TextureHandle(same->second);
+			}
+		}
+	}
+
+	misses++;
+	TextureEntry* entry = new TextureEntry();
+	entry->id = TextureLoader::instance().load(path, clampAlphaEdges);
+	entry->references = 0;
+	entry->hasContentHash = hasContentHash;
+	entry->contentHash = contentHash;
+	entry->pathKeys.push_back(key);
+	byPath[key] = entry;
+	if (hasContentHash)
+		byContent[contentHash] = entry;
+	liveTextures++;
+	return TextureHandle(entry);
+}
+
+void TextureRegistry::release(TextureEntry* entry)
+{
+	if (--entry->references > 0)
+		return;
+	for (unsigned int i = 0; i < entry->pathKeys.size(); i++)
+		byPath.erase(entry->pathKeys[i]);
+	if (entry->hasContentHash)
+		byContent.erase(entry->contentHash);
+	// The image may still be decoding, its upload must not hit the deleted (or a reused) name
+	TextureLoader::instance().cancel(entry->id);
+	glDeleteTextures(1, &entry->id);
+	liveTextures--;
+	delete entry;
+}
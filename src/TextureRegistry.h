@@ -0,0 +1,67 @@
+#pragma once
+// Std. Includes
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+// A texture owned by the TextureRegistry
+struct TextureEntry {
+    unsigned int id;
+    unsigned int references;
+    bool hasContentHash;
+    uint64_t contentHash;
+    // every path key that resolves to this texture
+    std::vector<std::string> pathKeys;
+};
+
+// Shared reference to a texture owned by the TextureRegistry. Copies share the texture,
+// the GL object is deleted when the last handle to it goes away.
+class TextureHandle {
+    public:
+        TextureHandle();
+        TextureHandle(const TextureHandle& other);
+        TextureHandle& operator=(const TextureHandle& other);
+        ~TextureHandle();
+        unsigned int id() const { return entry ? entry->id : 0; }
+
+    private:
+        friend class TextureRegistry;
+        explicit TextureHandle(TextureEntry* entry);
+        TextureEntry* entry;
+};
+
+// Process wide cache of image textures, shared by every Model. Textures are found by path in O(1);
+// with contentDedupe on, a path seen for the first time is also hashed by content so the same image
+// stored under another name (e.g. copied next to each furniture model) is decoded and uploaded only once.
+// Only to be used from the thread owning the GL context.
+class TextureRegistry {
+    public:
+        static TextureRegistry& instance();
+
+        // clampAlphaEdges is forwarded to TextureLoader::load and is part of the key
+        TextureHandle acquire(const std::string& path, bool clampAlphaEdges = false);
+
+        // Hash file contents on a path miss to find identical images under different paths. Off by
+        // default: the whole file is read and hashed synchronously on the calling (render) thread,
+        // and TextureLoader then reads it again on its worker, so each new path costs a blocking read.
+        // Worth it only when many paths share an image and loading happens behind a loading screen.
+        bool contentDedupe;
+
+        // Statistics
+        unsigned int liveTextures;
+        unsigned int pathHits;
+        unsigned int contentHits;
+        unsigned int misses;
+
+    private:
+        friend class TextureHandle;
+        TextureRegistry();
+        TextureRegistry(const TextureRegistry&);
+        TextureRegistry& operator=(const TextureRegistry&);
+
+        void release(TextureEntry* entry);
+
+        std::unordered_map<std::string, TextureEntry*> byPath;
+        std::unordered_map<uint64_t, TextureEntry*> byContent;
+};
@@ -0,0 +1,38 @@
+#include "UniformBlocks.h"
+#include "Camera.h"
+
+FrameUniforms::FrameUniforms()
+{
+	frame.view = glm::mat4(1.0f);
+	frame.projection = glm::mat4(1.0f);
+	frame.viewProjection = glm::mat4(1.0f);
+	frame.viewPos = glm::vec4(0.0f);
+	glGenBuffers(1, &UBO);
+	glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameConstants), &frame, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_CONSTANTS_BINDING, UBO);
+}
+
+FrameUniforms::~FrameUniforms()
+{
+	glDeleteBuffers(1, &UBO);
+}
+
+void FrameUniforms::update(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& viewPos)
+{
+	frame.view = view;
+	frame.projection = projection;
+	frame.viewProjection = projection * view;
+	frame.viewPos = glm::vec4(viewPos, 1.0f);
+	glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameConstants), &frame);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	// Someone may have bound another buffer to the binding point in the meantime
+	glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_CONSTANTS_BINDING, UBO);
+}
+
+void FrameUniforms::update(Camera& camera, const glm::mat4& projection)
+{
+	update(camera.GetViewMatrix(), projection, camera.Position);
+}
@@ -0,0 +1,60 @@
+#pragma once
+// GL Includes
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+class Camera;
+
+// Binding points of the uniform blocks every program shares. GLSL 330 has no layout(binding = N),
+// so Shader assigns them by block name after linking (bindUniformBlocks).
+enum UniformBlockBinding {
+    FRAME_CONSTANTS_BINDING = 0,
+    // LightBuffer
+    LIGHTS_BINDING = 1,
+    POINT_LIGHTS_BINDING = 2
+};
+
+// Points every shared block the program declares at its binding
+inline void bindUniformBlocks(GLuint program)
+{
+    static const struct { const char* name; GLuint binding; } blocks[] = {
+        { "FrameConstants", FRAME_CONSTANTS_BINDING },
+        { "Lights", LIGHTS_BINDING },
+        { "PointLights", POINT_LIGHTS_BINDING }
+    };
+    for (unsigned int i = 0; i < sizeof(blocks) / sizeof(blocks[0]); i++)
+    {
+        GLuint index = glGetUniformBlockIndex(program, blocks[i].name);
+        if (index != GL_INVALID_INDEX)
+            glUniformBlockBinding(program, index, blocks[i].binding);
+    }
+}
+
+// std140 layout of the FrameConstants block the shaders declare
+struct FrameConstants {
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::mat4 viewProjection;
+    // xyz: camera position, w unused
+    glm::vec4 viewPos;
+};
+
+// Camera matrices and position in one uniform buffer at FRAME_CONSTANTS_BINDING, written once per
+// frame instead of a view/projection/viewPos upload per program
+class FrameUniforms {
+    public:
+        FrameUniforms();
+        ~FrameUniforms();
+
+        void update(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& viewPos);
+        void update(Camera& camera, const glm::mat4& projection);
+
+        const FrameConstants& constants() const { return frame; }
+
+    private:
+        FrameUniforms(const FrameUniforms&);
+        FrameUniforms& operator=(const FrameUniforms&);
+
+        FrameConstants frame;
+        GLuint UBO;
+};
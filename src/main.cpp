@@ -15,6 +15,7 @@
 #include "Camera.h"
 #include "Mesh.h"
 #include "Model.h"
+#include "UniformBlocks.h"
 #include "stb_image.h"
 
 
@@ -88,6 +89,8 @@ int main()
     // -------------------------
     Shader shader(".\\src\\shaders\\VertexShader.vert", ".\\src\\shaders\\FragmentShader.frag");
     Shader shaderSingleColor(".\\src\\shaders\\stencil_single_color.vert", ".\\src\\shaders\\stencil_single_color.frag");
+    // view/projection of both programs
+    FrameUniforms frameUniforms;
 
     // set up vertex data (and buffer(s)) and configure vertex attributes
     // ------------------------------------------------------------------
@@ -203,23 +206,14 @@ int main()
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT); // don't forget to clear the stencil buffer!
 
         // set uniforms
-        shaderSingleColor.Use();
         glm::mat4 model = glm::mat4(1.0f);
-        glm::mat4 view = camera.GetViewMatrix();
         glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
+        // one write for both programs
+        frameUniforms.update(camera, projection);
+        shaderSingleColor.Use();
         GLint modelLoc = glGetUniformLocation(shaderSingleColor.Program, "model");
-        GLint viewLoc = glGetUniformLocation(shaderSingleColor.Program, "view");
-        GLint projLoc = glGetUniformLocation(shaderSingleColor.Program, "projection");
-        glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view));
-        glUniformMatrix4fv(projLoc, 1, GL_FALSE, glm::value_ptr(projection));
 
         shader.Use();
-        /*shader.setMat4("view", view);
-        shader.setMat4("projection", projection);*/
-        GLint viewLoc1 = glGetUniformLocation(shader.Program, "view");
-        GLint projLoc1 = glGetUniformLocation(shader.Program, "projection");
-        glUniformMatrix4fv(viewLoc1, 1, GL_FALSE, glm::value_ptr(view));
-        glUniformMatrix4fv(projLoc1, 1, GL_FALSE, glm::value_ptr(projection));
 
         // draw floor as normal, but don't write the floor to the stencil buffer, we only care about the containers. We set its mask to 0x00 to not write to the stencil buffer.
         glStencilMask(0x00);
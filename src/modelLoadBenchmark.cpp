@@ -0,0 +1,88 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include "stb_image.h"
+
+#include <glm/glm.hpp>
+
+#include "Shader.h"
+#include "Mesh.h"
+#include "Model.h"
+#include "MeshCache.h"
+#include "TextureLoader.h"
+
+#include <iostream>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+#include <string>
+
+// Compares cold (Assimp import + cache bake) against warm (mapped mesh cache) model loads.
+// Texture decoding and upload are excluded, the cache doesn't change them.
+// usage: modelLoadBenchmark [model.obj ...], defaults to the houseModel furniture
+static double loadModelMs(const std::string& path)
+{
+    std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+    Model model(path);
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+    // Untimed: the textures become resident before the model releases them
+    TextureLoader::instance().finish();
+    return elapsed.count();
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<std::string> paths;
+    for (int i = 1; i < argc; i++)
+        paths.push_back(argv[i]);
+    if (paths.empty())
+    {
+        paths.push_back(".\\Debug\\tableAndChair\\table.obj");
+        paths.push_back(".\\Debug\\simpleBed\\file.obj");
+        paths.push_back(".\\Debug\\kitchenSet8\\file.obj");
+        paths.push_back(".\\Debug\\shampoo\\file.obj");
+        paths.push_back(".\\Debug\\floorLamp\\file.obj");
+    }
+
+    // glfw: a hidden window is enough, Mesh::setUpMesh only needs a current context
+    // ------------------------------
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    GLFWwindow* window = glfwCreateWindow(64, 64, "model load benchmark", NULL, NULL);
+    if (window == NULL)
+    {
+        std::cout << "Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return -1;
+    }
+    stbi_set_flip_vertically_on_load(true);
+
+    // cold: drop any cache so Assimp runs and bakes a fresh one, warm: map what was just baked
+    // ------------------------------
+    double coldTotal = 0.0, warmTotal = 0.0;
+    for (unsigned int i = 0; i < paths.size(); i++)
+    {
+        std::remove(MeshCache::cachePath(paths[i]).c_str());
+        double cold = loadModelMs(paths[i]);
+        double warm = loadModelMs(paths[i]);
+        coldTotal += cold;
+        warmTotal += warm;
+        std::cout << paths[i] << ": cold " << cold << " ms, warm " << warm << " ms" << std::endl;
+    }
+    std::cout << "total: cold " << coldTotal << " ms, warm " << warmTotal << " ms";
+    if (warmTotal > 0.0)
+        std::cout << " (" << coldTotal / warmTotal << "x)";
+    std::cout << std::endl;
+
+    TextureLoader::instance().shutdown();
+    glfwTerminate();
+    return 0;
+}